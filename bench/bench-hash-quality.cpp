@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "hash.hpp"
+
+const size_t AVALANCHE_KEYS = 2000;
+const size_t AVALANCHE_LENGTHS[] = {4, 16, 64};
+const uint64_t BUCKET_COUNTS[] = {1 << 10, 1 << 16, 1 << 20};  ///< Also used minus one, as HashTable<0xfff> would be.
+const uint64_t THROUGHPUT_BYTES = 1 << 26;
+
+uint64_t checksum = 0;  ///< The throughput runs add their hashes here, and main prints it so none can be discarded.
+
+/**
+ * @brief A set of keys that hash functions are measured on.
+ */
+struct Corpus {
+  std::string name;
+  std::vector<std::string> keys;
+};
+
+/**
+ * @brief Split a text file into words, the way a message is split into tokens before it is classified.
+ */
+Corpus fileCorpus(const std::string &path) {
+  Corpus corpus{path, {}};
+  std::ifstream file(path, std::ios::binary);
+  std::string word;
+  char c;
+  while (file.get(c)) {
+    if (std::isalnum(static_cast<unsigned char>(c)) || (c & 0x80) || c == '\'' || c == '-') {
+      word += c;
+    } else if (!word.empty()) {
+      corpus.keys.push_back(word);
+      word.clear();
+    }
+  }
+  if (!word.empty()) corpus.keys.push_back(word);
+  return corpus;
+}
+
+/**
+ * @brief Make tokens that look like those of email: Zipf-distributed words in mixed case, numbers, addresses and URLs.
+ */
+Corpus emailCorpus(std::mt19937_64 &rng, size_t count) {
+  std::vector<std::string> vocabulary;
+  for (int i = 0; i < 50000; ++i) {
+    std::string word(2 + rng() % 3 + rng() % 8, '\0');
+    for (char &c : word) c = char('a' + rng() % 26);
+    vocabulary.push_back(word);
+  }
+  std::vector<double> weights(vocabulary.size());
+  for (size_t i = 0; i < weights.size(); ++i) weights[i] = 1.0 / double(i + 1);
+  std::discrete_distribution<size_t> zipf(weights.begin(), weights.end());
+
+  Corpus corpus{"email tokens", {}};
+  for (size_t i = 0; i < count; ++i) {
+    std::string word = vocabulary[zipf(rng)];
+    switch (rng() % 20) {
+      case 0:
+        word[0] = char(word[0] - 'a' + 'A');
+        break;
+      case 1:
+        std::transform(word.begin(), word.end(), word.begin(), [](char c) { return char(c - 'a' + 'A'); });
+        break;
+      case 2:
+        word = std::to_string(rng() % 100000);
+        break;
+      case 3:
+        word += "@" + vocabulary[zipf(rng)] + ".com";
+        break;
+      case 4:
+        word = "http://www." + word + ".com/" + vocabulary[zipf(rng)] + "?id=" + std::to_string(rng() % 1000000);
+        break;
+    }
+    corpus.keys.push_back(word);
+  }
+  return corpus;
+}
+
+/**
+ * @brief Make keys that are built to expose weak hash functions rather than to look like real data.
+ */
+std::vector<Corpus> adversarialCorpora(std::mt19937_64 &rng, size_t count) {
+  std::vector<Corpus> corpora;
+
+  Corpus numbers{"sequential numbers", {}};
+  for (size_t i = 0; i < count; ++i) numbers.keys.push_back(std::to_string(i));
+  corpora.push_back(numbers);
+
+  Corpus prefixed{"long shared prefix", {}};
+  for (size_t i = 0; i < count; ++i) prefixed.keys.push_back("X-Spam-Report: message-id=" + std::to_string(i));
+  corpora.push_back(prefixed);
+
+  Corpus bits{"one bit apart", {}};
+  std::string base(32, '\0');
+  for (char &c : base) c = char(rng());
+  for (size_t i = 0; i < count; ++i) {
+    std::string key = base;
+    // Flips two bits per key, so keys differ from each other in at most four.
+    key[(i / 256) % 32] ^= char(1 << ((i / 8192) % 8));
+    key[i % 32] ^= char(1 << ((i / 32) % 8));
+    bits.keys.push_back(key);
+  }
+  corpora.push_back(bits);
+
+  Corpus zeros{"zero bytes of every length", {}};
+  for (size_t i = 0; i < std::min<size_t>(count, 4096); ++i) zeros.keys.push_back(std::string(i, '\0'));
+  corpora.push_back(zeros);
+
+  Corpus alphabet{"two-letter alphabet", {}};
+  for (size_t i = 0; i < count; ++i) {
+    std::string key;
+    for (size_t bit = 0; bit < 20; ++bit) key += (i >> bit) & 1 ? 'b' : 'a';
+    alphabet.keys.push_back(key);
+  }
+  corpora.push_back(alphabet);
+
+  // Enough short keys that a hash keeping only 32 bits of them shows up in the collision count: a million keys of
+  // eight bytes give about a hundred collisions in 32 bits and none in 64.
+  Corpus eight{"random 8 bytes", {}};
+  for (size_t i = 0; i < count * 5; ++i) {
+    std::string key(8, '\0');
+    for (char &c : key) c = char(rng());
+    eight.keys.push_back(key);
+  }
+  corpora.push_back(eight);
+
+  Corpus mixed{"random 1-16 bytes", {}};
+  for (size_t i = 0; i < count * 5; ++i) {
+    std::string key(1 + rng() % 16, '\0');
+    for (char &c : key) c = char(rng());
+    mixed.keys.push_back(key);
+  }
+  corpora.push_back(mixed);
+
+  return corpora;
+}
+
+/**
+ * @brief Hash every key of a corpus over and over and report millions of keys and gigabytes per second.
+ */
+template <typename Hash>
+void throughput(Hash hash, const Corpus &corpus) {
+  size_t bytes = 0;
+  for (const std::string &key : corpus.keys) bytes += key.size();
+  uint64_t rounds = std::max<uint64_t>(1, THROUGHPUT_BYTES / std::max<size_t>(1, bytes));
+  uint64_t sum = 0;
+  auto begin = std::chrono::steady_clock::now();
+  for (uint64_t round = 0; round < rounds; ++round)
+    for (const std::string &key : corpus.keys) sum += hash(std::string_view(key));
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+  checksum += sum;
+  std::cout << std::setw(9) << double(rounds * corpus.keys.size()) / seconds / 1e6 << " M/s" << std::setw(8)
+            << double(rounds * bytes) / seconds / 1e9 << " GB/s";
+}
+
+/**
+ * @brief Measure how far flipping one input bit is from flipping each output bit with a probability of one half.
+ *
+ * Reports the mean and the worst bias over all pairs of input and output bits, where the bias of a pair is
+ * |2p - 1| for the measured probability p. An ideal hash has a worst bias of up to about 10% at this sample size,
+ * which is sampling noise. The folded hashes are biased by design, since flipping the case bit of a letter changes
+ * nothing.
+ */
+template <typename Hash>
+void avalanche(Hash hash, size_t length, std::mt19937_64 &rng) {
+  std::vector<uint32_t> flips(length * 8 * 64, 0);
+  std::string key(length, '\0');
+  for (size_t sample = 0; sample < AVALANCHE_KEYS; ++sample) {
+    for (char &c : key) c = char(rng());
+    uint64_t original = hash(std::string_view(key));
+    for (size_t bit = 0; bit < length * 8; ++bit) {
+      key[bit / 8] ^= char(1 << (bit % 8));
+      uint64_t changed = original ^ hash(std::string_view(key));
+      key[bit / 8] ^= char(1 << (bit % 8));
+      for (size_t out = 0; out < 64; ++out) flips[bit * 64 + out] += (changed >> out) & 1;
+    }
+  }
+  double total = 0, worst = 0;
+  for (uint32_t count : flips) {
+    double bias = std::fabs(2.0 * count / AVALANCHE_KEYS - 1.0);
+    total += bias;
+    worst = std::max(worst, bias);
+  }
+  std::cout << std::setw(7) << 100 * total / flips.size() << "%" << std::setw(7) << 100 * worst << "%";
+}
+
+/**
+ * @brief Place distinct keys into buckets as HashTable does with % buckets, or with a mask as a power-of-two table
+ * would.
+ *
+ * Reports the longest chain and the average number of entries compared by a successful lookup, divided by what a
+ * uniformly random hash would give. A ratio near 1.00 is ideal; a ratio of 2.00 means lookups walk twice as far.
+ */
+template <typename Hash>
+void occupancy(Hash hash, const std::vector<std::string> &keys, uint64_t buckets, bool mask) {
+  std::vector<uint32_t> chains(buckets, 0);
+  for (const std::string &key : keys) {
+    uint64_t full = hash(std::string_view(key));
+    ++chains[mask ? full & (buckets - 1) : full % buckets];
+  }
+  double n = double(keys.size()), compared = 0;
+  uint32_t longest = 0;
+  for (uint32_t chain : chains) {
+    compared += double(chain) * (chain + 1) / 2;
+    longest = std::max(longest, chain);
+  }
+  double expected = 1 + (n - 1) / (2 * double(buckets));
+  std::cout << std::setw(8) << longest << std::setw(9) << compared / n / expected;
+}
+
+/**
+ * @brief Count the distinct keys whose full 64-bit hash equals that of another key.
+ *
+ * The tables compare full hashes before identifiers, so every such key costs a string comparison on lookups that a
+ * uniformly random hash, which gives none at these sizes, would skip.
+ */
+template <typename Hash>
+void collisions(Hash hash, const std::vector<std::string> &keys) {
+  std::vector<uint64_t> hashes;
+  hashes.reserve(keys.size());
+  for (const std::string &key : keys) hashes.push_back(hash(std::string_view(key)));
+  std::sort(hashes.begin(), hashes.end());
+  uint64_t collided = 0;
+  for (size_t i = 1; i < hashes.size(); ++i) collided += hashes[i] == hashes[i - 1];
+  std::cout << std::setw(12) << collided;
+}
+
+/**
+ * @brief Run every measurement for one hash function on one corpus.
+ *
+ * @param keys The distinct keys of the corpus, which are the entries a table would hold.
+ */
+template <typename Hash>
+void report(const char *name, Hash hash, const Corpus &corpus, const std::vector<std::string> &keys) {
+  std::cout << std::setw(18) << name;
+  throughput(hash, corpus);
+  collisions(hash, keys);
+  for (uint64_t buckets : BUCKET_COUNTS) {
+    occupancy(hash, keys, buckets, true);
+    occupancy(hash, keys, buckets - 1, false);
+  }
+  std::cout << std::endl;
+}
+
+/**
+ * @brief Get the distinct keys of a corpus, as a table hashing with a given function would hold them.
+ *
+ * @param folded Whether keys that only differ in case are the same key.
+ */
+std::vector<std::string> distinct(const Corpus &corpus, bool folded) {
+  std::vector<std::string> keys;
+  for (const std::string &key : corpus.keys) keys.push_back(folded ? hash::foldCase(key) : key);
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  return keys;
+}
+
+/**
+ * @brief Run report for every hash function in namespace hash.
+ */
+void reportAll(const Corpus &corpus) {
+  std::vector<std::string> keys = distinct(corpus, false), foldedKeys = distinct(corpus, true);
+  std::cout << corpus.name << " (" << corpus.keys.size() << " keys, " << keys.size() << " distinct)" << std::endl;
+  std::cout << std::setw(18) << "" << std::setw(30) << "throughput" << std::setw(12) << "collisions";
+  for (uint64_t buckets : BUCKET_COUNTS)
+    std::cout << std::setw(17) << ("& " + std::to_string(buckets - 1)) << std::setw(17)
+              << ("% " + std::to_string(buckets - 1));
+  std::cout << std::endl;
+  std::cout << std::setw(60) << "";
+  for (size_t i = 0; i < 2 * std::size(BUCKET_COUNTS); ++i)
+    std::cout << std::setw(8) << "longest" << std::setw(9) << "cost";
+  std::cout << std::endl;
+  report("fnv1a_64", hash::fnv1a_64, corpus, keys);
+  report("wyhash64", hash::wyhash64, corpus, keys);
+  report("crc32c_64", hash::crc32c_64, corpus, keys);
+  report("fnv1a_64_folded", hash::fnv1a_64_folded, corpus, foldedKeys);
+  report("wyhash64_folded", hash::wyhash64_folded, corpus, foldedKeys);
+  report("crc32c_64_folded", hash::crc32c_64_folded, corpus, foldedKeys);
+  report("mod10", hash::mod10, corpus, keys);
+  std::cout << std::endl;
+}
+
+/**
+ * @brief Run avalanche for one hash function at every key length.
+ */
+template <typename Hash>
+void avalancheAll(const char *name, Hash hash, std::mt19937_64 &rng) {
+  std::cout << std::setw(18) << name;
+  for (size_t length : AVALANCHE_LENGTHS) avalanche(hash, length, rng);
+  std::cout << std::endl;
+}
+
+int main(int argc, char **argv) {
+  std::mt19937_64 rng(42);
+  std::cout << std::fixed << std::setprecision(2);
+
+  std::vector<Corpus> corpora;
+  // Any text files given on the command line, such as a mailbox, are measured as well.
+  for (int i = 1; i < argc; ++i) corpora.push_back(fileCorpus(argv[i]));
+  corpora.push_back(emailCorpus(rng, 500000));
+  for (Corpus &corpus : adversarialCorpora(rng, 200000)) corpora.push_back(corpus);
+  for (const Corpus &corpus : corpora) reportAll(corpus);
+
+  std::cout << "avalanche bias (mean, worst)" << std::endl << std::setw(18) << "";
+  for (size_t length : AVALANCHE_LENGTHS) std::cout << std::setw(14) << (std::to_string(length) + " bytes");
+  std::cout << std::endl;
+  avalancheAll("fnv1a_64", hash::fnv1a_64, rng);
+  avalancheAll("wyhash64", hash::wyhash64, rng);
+  avalancheAll("crc32c_64", hash::crc32c_64, rng);
+  avalancheAll("fnv1a_64_folded", hash::fnv1a_64_folded, rng);
+  avalancheAll("wyhash64_folded", hash::wyhash64_folded, rng);
+  avalancheAll("crc32c_64_folded", hash::crc32c_64_folded, rng);
+  avalancheAll("mod10", hash::mod10, rng);
+  std::cout << std::endl << "(checksum " << checksum << ")" << std::endl;
+}
@@ -0,0 +1,120 @@
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "hash.hpp"
+
+const uint64_t BYTES_PER_RUN = 1 << 28;
+const size_t KEY_LENGTHS[] = {4, 8, 16, 32, 64, 128, 256, 1024, 4096, 65536};
+
+uint64_t checksum = 0;  ///< Every measurement adds its hashes here, and main prints it so none can be discarded.
+
+/**
+ * @brief Hash a buffer of keys of one length over and over and report the throughput in GB/s.
+ */
+template <typename Hash>
+double throughput(Hash hash, const std::string &buffer, size_t length) {
+  size_t keys = buffer.size() / length;
+  uint64_t rounds = BYTES_PER_RUN / (keys * length);
+  uint64_t sum = 0;
+  auto begin = std::chrono::steady_clock::now();
+  for (uint64_t round = 0; round < rounds; ++round)
+    for (size_t key = 0; key < keys; ++key) sum += hash(buffer.data() + key * length, length);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+  checksum += sum;
+  return double(rounds * keys * length) / seconds / 1e9;
+}
+
+/**
+ * @brief Hash a list of short tokens, one at a time and in batches, with fnv1a_64 and wyhash128, and report millions of
+ * tokens per second.
+ */
+void tokens(std::mt19937_64 &rng) {
+  std::vector<std::string> storage;
+  for (int i = 0; i < 4096; ++i) storage.push_back(std::string(3 + rng() % 10, char('a' + rng() % 26)));
+  std::vector<std::string_view> keys(storage.begin(), storage.end());
+  std::vector<uint64_t> hashes(keys.size());
+  const int rounds = 2000;
+
+  auto begin = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; ++round)
+    for (size_t i = 0; i < keys.size(); ++i) hashes[i] = hash::fnv1a_64(keys[i]);
+  double scalar = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+  begin = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; ++round) hash::batch(keys.data(), keys.size(), hashes.data());
+  double batched = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+  std::vector<hash::Hash128> fingerprints(keys.size());
+  begin = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; ++round)
+    for (size_t i = 0; i < keys.size(); ++i) fingerprints[i] = hash::wyhash128(keys[i]);
+  double scalar128 = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+  begin = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; ++round) hash::batch128(keys.data(), keys.size(), fingerprints.data());
+  double batched128 = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+  checksum += hashes[0] ^ fingerprints[0].high;
+  std::cout << "3-12 byte tokens: fnv1a_64 " << (rounds * keys.size() / scalar / 1e6) << " M/s, batch "
+            << (rounds * keys.size() / batched / 1e6) << " M/s" << std::endl;
+  std::cout << "3-12 byte tokens: wyhash128 " << (rounds * keys.size() / scalar128 / 1e6) << " M/s, batch128 "
+            << (rounds * keys.size() / batched128 / 1e6) << " M/s" << std::endl;
+}
+
+/**
+ * @brief Hash every 5-gram of a buffer, window by window and with a rolling hash, and report millions of n-grams per
+ * second.
+ */
+void ngrams(const std::string &buffer) {
+  const size_t k = 5;
+  std::string_view text(buffer);
+  size_t count = text.size() - k + 1;
+  std::vector<uint64_t> hashes(count);
+
+  const int rounds = 20;
+
+  auto begin = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; ++round)
+    for (size_t i = 0; i < count; ++i) hashes[i] = hash::fnv1a_64(text.substr(i, k));
+  double windows = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+  begin = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; ++round) hashes = hash::kgrams(text, k);
+  double rolling = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+  checksum += hashes[0];
+  std::cout << "5-grams: fnv1a_64 per window " << (rounds * count / windows / 1e6) << " M/s, kgrams "
+            << (rounds * count / rolling / 1e6) << " M/s" << std::endl;
+}
+
+int main(int, char **) {
+  // Both halves go into the checksum, so neither can be skipped.
+  auto fingerprint = [](const void *data, size_t length) {
+    hash::Hash128 hash = hash::wyhash128(data, length);
+    return hash.low ^ hash.high;
+  };
+  std::mt19937_64 rng(42);
+  std::string buffer(1 << 20, '\0');
+  for (char &c : buffer) c = char(rng());
+
+  std::cout << std::setw(10) << "length" << std::setw(14) << "fnv1a_64" << std::setw(14) << "wyhash64" << std::setw(14)
+            << "crc32c_64" << std::setw(14) << "wyhash128" << std::endl;
+  std::cout << std::fixed << std::setprecision(2);
+  for (size_t length : KEY_LENGTHS) {
+    std::cout << std::setw(10) << length;
+    std::cout << std::setw(9) << throughput(hash::fnv1a_64, buffer, length) << " GB/s";
+    std::cout << std::setw(9) << throughput(hash::wyhash64, buffer, length) << " GB/s";
+    std::cout << std::setw(9) << throughput(hash::crc32c_64, buffer, length) << " GB/s";
+    std::cout << std::setw(9) << throughput(fingerprint, buffer, length) << " GB/s" << std::endl;
+  }
+  std::cout << std::endl;
+  tokens(rng);
+  ngrams(buffer);
+  std::cout << "(checksum " << checksum << ")" << std::endl;
+}
@@ -0,0 +1,113 @@
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "hashtable.hpp"
+#include "hugepageresource.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+const uint64_t BUCKETS = 1 << 22;
+const uint64_t ENTRIES = 2000000;
+const uint64_t LOOKUPS = 5000000;
+
+/**
+ * @brief Counts data TLB misses of the calling thread, where the kernel allows it.
+ */
+class TlbMissCounter {
+ private:
+  int mFd = -1;
+
+ public:
+  TlbMissCounter() {
+#ifdef __linux__
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config =
+        PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    this->mFd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+  }
+
+  ~TlbMissCounter() {
+#ifdef __linux__
+    if (this->mFd >= 0) close(this->mFd);
+#endif
+  }
+
+  bool available() const { return this->mFd >= 0; }
+
+  void start() {
+#ifdef __linux__
+    if (!this->available()) return;
+    ioctl(this->mFd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(this->mFd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+  }
+
+  uint64_t stop() {
+    uint64_t count = 0;
+#ifdef __linux__
+    if (!this->available()) return 0;
+    ioctl(this->mFd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(this->mFd, &count, sizeof(count)) != sizeof(count)) count = 0;
+#endif
+    return count;
+  }
+};
+
+/**
+ * @brief Fill a table backed by the given resource and time random lookups into it.
+ */
+void run(const char *name, std::pmr::memory_resource *upstream, const std::vector<std::string> &keys,
+         const std::vector<uint32_t> &order) {
+  std::pmr::monotonic_buffer_resource arena(HugePageResource::HUGE_PAGE_SIZE, upstream);
+  HashTable<BUCKETS, int> table(hash::fnv1a_64, &arena);
+  for (uint64_t i = 0; i < keys.size(); ++i) table.set(keys[i], i);
+
+  TlbMissCounter counter;
+  uint64_t checksum = 0;
+  auto begin = std::chrono::steady_clock::now();
+  counter.start();
+  for (uint32_t i : order) checksum += table.get(keys[i]).value_or(0);
+  uint64_t misses = counter.stop();
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+  std::cout << name << "\t" << (seconds * 1e9 / order.size()) << " ns/lookup\t";
+  if (counter.available())
+    std::cout << (double(misses) / order.size()) << " dTLB misses/lookup";
+  else
+    std::cout << "dTLB misses unavailable";
+  std::cout << "\t(checksum " << checksum << ")" << std::endl;
+}
+
+int main(int, char **) {
+  std::mt19937_64 rng(42);
+  std::vector<std::string> keys;
+  for (uint64_t i = 0; i < ENTRIES; ++i) keys.push_back("token" + std::to_string(rng()));
+  std::vector<uint32_t> order;
+  for (uint64_t i = 0; i < LOOKUPS; ++i) order.push_back(rng() % ENTRIES);
+
+  run("4 KB pages", std::pmr::new_delete_resource(), keys, order);
+
+  HugePageResource hugePages;
+  run("huge pages", &hugePages, keys, order);
+  HugePageResource::Stats stats = hugePages.stats();
+  std::cout << "huge page backing: " << stats.hugetlb << " bytes MAP_HUGETLB, " << stats.madvised
+            << " bytes MADV_HUGEPAGE, " << stats.fallback << " bytes fallback" << std::endl;
+}
@@ -0,0 +1,113 @@
+#include "bloomfilter.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "hash.hpp"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BLOOM_FILTER_AVX2
+#endif
+
+namespace {
+const uint32_t WORDS = BloomFilter::BLOCK_BYTES / sizeof(uint32_t);
+
+/**
+ * @brief Odd constants that spread a 32-bit key over the eight words of a block, one bit per word.
+ */
+const uint32_t SALTS[WORDS] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                               0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+void insertScalar(uint32_t *block, uint32_t key) {
+  for (uint32_t i = 0; i < WORDS; ++i) block[i] |= uint32_t(1) << ((key * SALTS[i]) >> 27);
+}
+
+bool mayContainScalar(const uint32_t *block, uint32_t key) {
+  for (uint32_t i = 0; i < WORDS; ++i)
+    if ((block[i] & (uint32_t(1) << ((key * SALTS[i]) >> 27))) == 0) return false;
+  return true;
+}
+
+#ifdef BLOOM_FILTER_AVX2
+/**
+ * @brief Compute the bit to test or set in each of the eight words of a block.
+ */
+__attribute__((target("avx2"))) inline __m256i maskAvx2(uint32_t key) {
+  const __m256i salts = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(SALTS));
+  __m256i shifts = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(key), salts), 27);
+  return _mm256_sllv_epi32(_mm256_set1_epi32(1), shifts);
+}
+
+__attribute__((target("avx2"))) void insertAvx2(uint32_t *block, uint32_t key) {
+  __m256i *words = reinterpret_cast<__m256i *>(block);
+  _mm256_store_si256(words, _mm256_or_si256(_mm256_load_si256(words), maskAvx2(key)));
+}
+
+__attribute__((target("avx2"))) bool mayContainAvx2(const uint32_t *block, uint32_t key) {
+  return _mm256_testc_si256(_mm256_load_si256(reinterpret_cast<const __m256i *>(block)), maskAvx2(key));
+}
+
+const bool HAS_AVX2 = __builtin_cpu_supports("avx2");
+#else
+const bool HAS_AVX2 = false;
+#endif
+}  // namespace
+
+BloomFilter::BloomFilter(uint64_t capacity, uint32_t bitsPerEntry, std::pmr::memory_resource *resource)
+    : mResource(resource),
+      mBlocks(nullptr),
+      mBlockCount(std::max<uint64_t>(1, (std::max<uint64_t>(1, capacity) * bitsPerEntry + BLOCK_BYTES * 8 - 1) /
+                                            (BLOCK_BYTES * 8))),
+      mCapacity(capacity),
+      mBitsPerEntry(bitsPerEntry) {
+  this->mBlocks = static_cast<uint32_t *>(resource->allocate(this->mBlockCount * BLOCK_BYTES, BLOCK_BYTES));
+  this->clear();
+}
+
+BloomFilter::BloomFilter(BloomFilter &&other) noexcept
+    : mResource(other.mResource),
+      mBlocks(other.mBlocks),
+      mBlockCount(other.mBlockCount),
+      mCapacity(other.mCapacity),
+      mBitsPerEntry(other.mBitsPerEntry) {
+  other.mBlocks = nullptr;
+}
+
+BloomFilter &BloomFilter::operator=(BloomFilter &&other) noexcept {
+  if (this != &other) {
+    if (this->mBlocks != nullptr) this->mResource->deallocate(this->mBlocks, this->mBlockCount * BLOCK_BYTES, BLOCK_BYTES);
+    this->mResource = other.mResource;
+    this->mBlocks = other.mBlocks;
+    this->mBlockCount = other.mBlockCount;
+    this->mCapacity = other.mCapacity;
+    this->mBitsPerEntry = other.mBitsPerEntry;
+    other.mBlocks = nullptr;
+  }
+  return *this;
+}
+
+BloomFilter::~BloomFilter() {
+  if (this->mBlocks != nullptr) this->mResource->deallocate(this->mBlocks, this->mBlockCount * BLOCK_BYTES, BLOCK_BYTES);
+}
+
+void BloomFilter::insert(uint64_t hash) {
+  // The high bits select the block, and FNV-1a barely changes them between similar short keys.
+  hash = hash::mix64(hash);
+#ifdef BLOOM_FILTER_AVX2
+  if (HAS_AVX2) return insertAvx2(this->block(hash), uint32_t(hash));
+#endif
+  insertScalar(this->block(hash), uint32_t(hash));
+}
+
+bool BloomFilter::mayContain(uint64_t hash) const {
+  hash = hash::mix64(hash);
+#ifdef BLOOM_FILTER_AVX2
+  if (HAS_AVX2) return mayContainAvx2(this->block(hash), uint32_t(hash));
+#endif
+  return mayContainScalar(this->block(hash), uint32_t(hash));
+}
+
+void BloomFilter::clear() { std::memset(this->mBlocks, 0, this->mBlockCount * BLOCK_BYTES); }
+
+bool BloomFilter::vectorized() { return HAS_AVX2; }
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "hash.hpp"
+
+/**
+ * @brief A hash table with a fixed capacity that evicts old entries using the CLOCK algorithm.
+ *
+ * Entries live in a fixed array of slots, and a separate open-addressing index maps hashes to slots. Every slot has a
+ * reference bit that is set whenever an existing entry is read or overwritten. New entries start with the bit clear,
+ * so an entry that is inserted once and never used again is the first to go. When a new entry needs a slot and the
+ * cache is full, a clock hand sweeps over the slots, clearing reference bits, until it finds one whose bit is already
+ * clear, and evicts that entry. This approximates least-recently-used eviction in amortized constant time without
+ * keeping a linked list through the entries.
+ *
+ * @tparam capacity The maximum number of entries in the cache.
+ * @tparam T The type of data to be stored in the cache.
+ */
+template <uint64_t capacity, typename T>
+class ClockCache {
+ public:
+  /**
+   * @brief Counters describing how well the cache is doing.
+   */
+  struct Stats {
+    uint64_t hits;       ///< Lookups that found their identifier.
+    uint64_t misses;     ///< Lookups that did not find their identifier.
+    uint64_t evictions;  ///< Entries that were evicted to make room for new ones.
+  };
+
+ private:
+  static_assert(capacity > 0 && capacity < UINT32_MAX, "ClockCache capacity must fit in 32 bits");
+
+  /**
+   * @brief Get the smallest power of two that is at least twice the capacity, so the index stays at most half full.
+   */
+  static constexpr uint64_t indexSize() {
+    uint64_t size = 1;
+    while (size < capacity * 2) size *= 2;
+    return size;
+  }
+
+  static constexpr uint64_t INDEX_SIZE = indexSize();
+  static constexpr uint32_t EMPTY = 0;
+
+  /**
+   * @brief A slot holding one entry of the cache.
+   */
+  struct Slot {
+    std::string identifier;
+    T data = T();
+    uint64_t hash = 0;
+    bool referenced = false;
+  };
+
+  std::function<uint64_t(std::string_view)> mHashFunc;
+  std::unique_ptr<Slot[]> mSlots;
+  std::unique_ptr<uint32_t[]> mIndex;  ///< Slot number plus one, or EMPTY.
+  std::vector<uint32_t> mFree;
+  uint64_t mSize;
+  uint64_t mUsed;
+  uint64_t mHand;
+  Stats mStats;
+
+  /**
+   * @brief Find the index position that refers to an identifier.
+   *
+   * @param identifier The identifier to search for.
+   * @param hash The full hash of the identifier.
+   * @return The position in the index, or the empty position where the identifier would be inserted.
+   */
+  uint64_t find(const std::string &identifier, uint64_t hash) const {
+    uint64_t position = hash & (INDEX_SIZE - 1);
+    while (this->mIndex[position] != EMPTY) {
+      const Slot &slot = this->mSlots[this->mIndex[position] - 1];
+      if (slot.hash == hash && slot.identifier == identifier) return position;
+      position = (position + 1) & (INDEX_SIZE - 1);
+    }
+    return position;
+  }
+
+  /**
+   * @brief Remove a position from the index, shifting later entries of the same probe run back into the gap.
+   *
+   * @param hole The position to remove.
+   */
+  void unindex(uint64_t hole) {
+    uint64_t next = hole;
+    while (true) {
+      next = (next + 1) & (INDEX_SIZE - 1);
+      if (this->mIndex[next] == EMPTY) break;
+      uint64_t home = this->mSlots[this->mIndex[next] - 1].hash & (INDEX_SIZE - 1);
+      bool movable = hole <= next ? (home <= hole || home > next) : (home <= hole && home > next);
+      if (movable) {
+        this->mIndex[hole] = this->mIndex[next];
+        hole = next;
+      }
+    }
+    this->mIndex[hole] = EMPTY;
+  }
+
+  /**
+   * @brief Advance the clock hand until it finds an unreferenced entry, and evict it.
+   *
+   * @return The slot that was freed.
+   */
+  uint32_t evict() {
+    while (this->mSlots[this->mHand].referenced) {
+      this->mSlots[this->mHand].referenced = false;
+      this->mHand = this->mHand + 1 == capacity ? 0 : this->mHand + 1;
+    }
+    uint32_t victim = this->mHand;
+    this->mHand = this->mHand + 1 == capacity ? 0 : this->mHand + 1;
+
+    Slot &slot = this->mSlots[victim];
+    this->unindex(this->find(slot.identifier, slot.hash));
+    ++this->mStats.evictions;
+    --this->mSize;
+    return victim;
+  }
+
+ public:
+  /**
+   * @brief Construct a new Clock Cache<capacity, T> object
+   *
+   * @param hashFunc The hashing function to be used by this cache.
+   */
+  ClockCache<capacity, T>(std::function<uint64_t(std::string_view)> hashFunc = hash::fnv1a_64)
+      : mHashFunc(hashFunc),
+        mSlots(std::make_unique<Slot[]>(capacity)),
+        mIndex(std::make_unique<uint32_t[]>(INDEX_SIZE)),
+        mSize(0),
+        mUsed(0),
+        mHand(0),
+        mStats{0, 0, 0} {}
+
+  /**
+   * @brief Get the number of entries in the cache.
+   *
+   * @return The number of entries.
+   */
+  uint64_t size() const { return this->mSize; }
+
+  /**
+   * @brief Get the hit, miss and eviction counters.
+   *
+   * @return The counters accumulated since the cache was created.
+   */
+  Stats stats() const { return this->mStats; }
+
+  /**
+   * @brief Get the data stored at a given identifier, marking it as recently used.
+   *
+   * @param identifier The identifier of the requested data.
+   * @return The data stored at the given identifier, if it exists.
+   */
+  std::optional<T> get(std::string identifier) {
+    uint64_t position = this->find(identifier, this->mHashFunc(identifier));
+    if (this->mIndex[position] == EMPTY) {
+      ++this->mStats.misses;
+      return std::nullopt;
+    }
+    ++this->mStats.hits;
+    Slot &slot = this->mSlots[this->mIndex[position] - 1];
+    slot.referenced = true;
+    return slot.data;
+  }
+
+  /**
+   * @brief Set the data stored at an identifier.
+   *
+   * Will create a new entry if one does not already exist, evicting another entry if the cache is full. The new entry
+   * is not marked as recently used until it is read or overwritten.
+   * If an entry with the given identifier already exists, its data will be replaced and it is marked as recently used.
+   *
+   * @param identifier The identifier of the data.
+   * @param data The data to be stored.
+   */
+  void set(std::string identifier, T data) {
+    uint64_t hash = this->mHashFunc(identifier);
+    uint64_t position = this->find(identifier, hash);
+    if (this->mIndex[position] != EMPTY) {
+      Slot &slot = this->mSlots[this->mIndex[position] - 1];
+      slot.data = data;
+      slot.referenced = true;
+      return;
+    }
+
+    uint32_t free;
+    if (!this->mFree.empty()) {
+      free = this->mFree.back();
+      this->mFree.pop_back();
+    } else if (this->mUsed < capacity) {
+      free = this->mUsed++;
+    } else {
+      free = this->evict();
+      position = this->find(identifier, hash);
+    }
+
+    Slot &slot = this->mSlots[free];
+    slot.identifier.assign(identifier);
+    slot.data = data;
+    slot.hash = hash;
+    // Only a second use marks an entry, so a burst of one-off insertions evicts itself before older entries in use.
+    slot.referenced = false;
+    this->mIndex[position] = free + 1;
+    ++this->mSize;
+  }
+
+  /**
+   * @brief Remove an entry from the cache.
+   *
+   * @param identifier The identifier of the data to be removed.
+   * @return true if the entry was successfully removed.
+   * @return false if the identifier does not exist in the cache.
+   */
+  bool remove(std::string identifier) {
+    uint64_t position = this->find(identifier, this->mHashFunc(identifier));
+    if (this->mIndex[position] == EMPTY) return false;
+    uint32_t slot = this->mIndex[position] - 1;
+    this->unindex(position);
+    // A freed slot would otherwise stay marked as recently used and shield itself from the next sweep.
+    this->mSlots[slot].referenced = false;
+    this->mFree.push_back(slot);
+    --this->mSize;
+    return true;
+  }
+};
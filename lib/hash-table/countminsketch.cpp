@@ -0,0 +1,37 @@
+#include "countminsketch.hpp"
+
+#include <algorithm>
+
+namespace {
+const uint64_t SEED_STEP = 0x9e3779b97f4a7c15U;  ///< 2^64 divided by the golden ratio, so row seeds are far apart.
+}  // namespace
+
+CountMinSketch::CountMinSketch(uint64_t width, uint32_t depth, std::function<uint64_t(std::string_view)> hashFunc)
+    : mHashFunc(hashFunc),
+      mCounters(std::max<uint64_t>(1, width) * std::max<uint32_t>(1, depth), 0),
+      mWidth(std::max<uint64_t>(1, width)),
+      mDepth(std::max<uint32_t>(1, depth)) {}
+
+uint64_t CountMinSketch::counter(uint64_t hash, uint32_t row) const {
+  // Each row remixes the one hash with its own seed, so the string is only hashed once however deep the sketch is.
+  uint64_t seeded = hash::mix64(hash + SEED_STEP * (row + 1));
+  return row * this->mWidth + ((seeded >> 32) * this->mWidth >> 32);
+}
+
+uint32_t CountMinSketch::addHash(uint64_t hash, uint32_t count) {
+  uint32_t minimum = this->estimateHash(hash);
+  uint32_t target = minimum > UINT32_MAX - count ? UINT32_MAX : minimum + count;
+  for (uint32_t row = 0; row < this->mDepth; ++row) {
+    uint32_t &value = this->mCounters[this->counter(hash, row)];
+    value = std::max(value, target);
+  }
+  return target;
+}
+
+uint32_t CountMinSketch::estimateHash(uint64_t hash) const {
+  uint32_t minimum = UINT32_MAX;
+  for (uint32_t row = 0; row < this->mDepth; ++row) minimum = std::min(minimum, this->mCounters[this->counter(hash, row)]);
+  return minimum;
+}
+
+void CountMinSketch::clear() { std::fill(this->mCounters.begin(), this->mCounters.end(), 0); }
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "hash.hpp"
+
+/**
+ * @brief A count-min sketch that estimates how often each identifier was counted, in a fixed amount of memory.
+ *
+ * The sketch is a grid of counters with one row per seed. Counting an identifier increments one counter in every row,
+ * chosen by the identifier's hash mixed with that row's seed, and the estimate is the smallest of those counters. An
+ * estimate is never below the true count, and with a width of w it exceeds the true count by more than 2N/w, where N is
+ * the total of all counts, with probability at most 2^-depth.
+ *
+ * Counting uses conservative update: only the counters that are at the current minimum are raised, which leaves the
+ * estimate unchanged but keeps the other counters, and so the estimates of colliding identifiers, lower.
+ */
+class CountMinSketch {
+ public:
+  /**
+   * @brief Construct a new Count Min Sketch object
+   *
+   * @param width The number of counters in each row.
+   * @param depth The number of rows, each with its own seed.
+   * @param hashFunc The hashing function that identifiers are hashed with once, before seeding.
+   */
+  explicit CountMinSketch(uint64_t width, uint32_t depth = 4,
+                          std::function<uint64_t(std::string_view)> hashFunc = hash::fnv1a_64);
+
+  /**
+   * @brief Count an identifier.
+   *
+   * Counters saturate at UINT32_MAX instead of wrapping around.
+   *
+   * @param identifier The identifier to count.
+   * @param count How many times to count it.
+   * @return The new estimate for the identifier.
+   */
+  uint32_t add(std::string identifier, uint32_t count = 1) { return this->addHash(this->mHashFunc(identifier), count); }
+
+  /**
+   * @brief Count an identifier by its hash.
+   *
+   * @param hash The hash of the identifier, from the sketch's hashing function.
+   * @param count How many times to count it.
+   * @return The new estimate for the identifier.
+   */
+  uint32_t addHash(uint64_t hash, uint32_t count = 1);
+
+  /**
+   * @brief Estimate how often an identifier was counted.
+   *
+   * @param identifier The identifier to look up.
+   * @return An upper bound on the number of times the identifier was counted.
+   */
+  uint32_t estimate(std::string identifier) const { return this->estimateHash(this->mHashFunc(identifier)); }
+
+  /**
+   * @brief Estimate how often an identifier was counted, by its hash.
+   *
+   * @param hash The hash of the identifier, from the sketch's hashing function.
+   * @return An upper bound on the number of times the identifier was counted.
+   */
+  uint32_t estimateHash(uint64_t hash) const;
+
+  /**
+   * @brief Reset every counter to zero.
+   */
+  void clear();
+
+  /**
+   * @brief Get the number of counters in each row.
+   *
+   * @return The width of the sketch.
+   */
+  uint64_t width() const { return this->mWidth; }
+
+  /**
+   * @brief Get the number of rows.
+   *
+   * @return The depth of the sketch.
+   */
+  uint32_t depth() const { return this->mDepth; }
+
+  /**
+   * @brief Get the number of bytes used by the counters.
+   *
+   * @return The size of the sketch in bytes.
+   */
+  uint64_t memoryUsage() const { return this->mCounters.size() * sizeof(uint32_t); }
+
+ private:
+  std::function<uint64_t(std::string_view)> mHashFunc;
+  std::vector<uint32_t> mCounters;
+  uint64_t mWidth;
+  uint32_t mDepth;
+
+  /**
+   * @brief Get the position of the counter that a hash maps to in a row.
+   *
+   * @param hash The hash of an identifier.
+   * @param row The row of the counter.
+   * @return The index of the counter in mCounters.
+   */
+  uint64_t counter(uint64_t hash, uint32_t row) const;
+};
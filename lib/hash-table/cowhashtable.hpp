@@ -0,0 +1,267 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "hash.hpp"
+#include "hashtable.hpp"
+
+/**
+ * @brief A hash table that can take constant-time, copy-on-write snapshots of itself.
+ *
+ * Buckets are stored in fixed-size groups, and the table refers to its groups through a shared directory. Taking a
+ * snapshot only shares the directory. The first write after a snapshot copies the directory, which is a list of
+ * pointers, and every write copies the group it lands in if that group is still shared. A snapshot therefore costs
+ * nothing up front and the table only pays for the groups that are written while the snapshot is alive.
+ *
+ * Snapshots are immutable and may be read from any thread while the table keeps being written to. The table itself,
+ * including snapshot(), must only be used from one thread at a time. The table counts the snapshots that are alive, and
+ * writes in place whatever no live snapshot can see, without relying on shared_ptr::use_count, which gives no ordering.
+ *
+ * The directories, groups and entries are allocated from the table's memory resource, and are returned to it by
+ * whichever of the table and its snapshots releases them last. If snapshots are destroyed on other threads than the
+ * table's, the resource must therefore be safe to use from several threads, as the default resource and
+ * std::pmr::synchronized_pool_resource are.
+ *
+ * @tparam buckets How many buckets are to be used in the table.
+ * @tparam T The type of data to be stored in the table.
+ * @tparam groupSize How many buckets are copied together when a shared group is written to.
+ */
+template <uint64_t buckets, typename T, uint64_t groupSize = 64>
+class CowHashTable {
+ private:
+  static constexpr uint64_t GROUPS = (buckets + groupSize - 1) / groupSize;
+
+  /**
+   * @brief A group of consecutive buckets that is shared and copied as a whole.
+   */
+  struct Group {
+    HashEntryPtr<T> chains[groupSize];
+    uint64_t generation = 0;  ///< The generation of the table when the group was created or copied.
+  };
+
+  using Directory = std::pmr::vector<std::shared_ptr<Group>>;
+
+  std::function<uint64_t(std::string_view)> mHashFunc;
+  std::pmr::memory_resource *mResource;
+  std::shared_ptr<Directory> mDirectory;
+  uint64_t mDirectoryGeneration;                      ///< The generation of the table when the directory was copied.
+  mutable uint64_t mGeneration;                       ///< Advanced by every snapshot.
+  std::shared_ptr<std::atomic<uint64_t>> mSnapshots;  ///< The number of snapshots alive, shared with them.
+
+  /**
+   * @brief Search a directory for an identifier.
+   *
+   * @param directory The directory to search.
+   * @param identifier The identifier to search for.
+   * @param hash The full hash of the identifier.
+   * @return The data stored at the given identifier, if it exists.
+   */
+  static std::optional<T> search(const Directory &directory, const std::string &identifier, uint64_t hash) {
+    uint64_t bucket = hash % buckets;
+    const std::shared_ptr<Group> &group = directory[bucket / groupSize];
+    if (group == nullptr || group->chains[bucket % groupSize] == nullptr) return std::nullopt;
+    return group->chains[bucket % groupSize]->search(identifier, hash);
+  }
+
+  /**
+   * @brief Check whether the directory or a group may be written in place.
+   *
+   * Anything created or copied since the last snapshot is only reachable from the table. Anything older may still be
+   * reachable from a snapshot, unless none is alive. Snapshots release their directory before they count themselves
+   * out with release ordering, and the count is read with acquire ordering, so once it is zero every read a snapshot
+   * made also happened before the write.
+   *
+   * @param generation The generation the directory or group was stamped with.
+   * @return true if no snapshot can see it.
+   */
+  bool writable(uint64_t generation) const {
+    return generation == this->mGeneration || this->mSnapshots->load(std::memory_order_acquire) == 0;
+  }
+
+  /**
+   * @brief Get a bucket that may be written to, copying the directory and its group first if they are shared.
+   *
+   * @param bucket The index of the bucket.
+   * @return The first entry of the bucket.
+   */
+  HashEntryPtr<T> &writableBucket(uint64_t bucket) {
+    std::pmr::polymorphic_allocator<Group> allocator(this->mResource);
+    if (!this->writable(this->mDirectoryGeneration)) {
+      this->mDirectory = std::allocate_shared<Directory>(allocator, *this->mDirectory);
+      this->mDirectoryGeneration = this->mGeneration;
+    }
+
+    std::shared_ptr<Group> &group = (*this->mDirectory)[bucket / groupSize];
+    if (group == nullptr) {
+      group = std::allocate_shared<Group>(allocator);
+      group->generation = this->mGeneration;
+    } else if (!this->writable(group->generation)) {
+      std::shared_ptr<Group> copy = std::allocate_shared<Group>(allocator);
+      copy->generation = this->mGeneration;
+      for (uint64_t i = 0; i < groupSize; ++i) {
+        HashEntryPtr<T> *tail = &copy->chains[i];
+        for (const HashEntry<T> *entry = group->chains[i].get(); entry != nullptr; entry = entry->mNext.get()) {
+          *tail = makeHashEntry<T>(this->mResource, entry->getIdentifier(), entry->get(), entry->getHash());
+          tail = &(*tail)->mNext;
+        }
+      }
+      group = copy;
+    }
+    return group->chains[bucket % groupSize];
+  }
+
+ public:
+  /**
+   * @brief A read-only view of the table as it was when the snapshot was taken.
+   */
+  class Snapshot {
+   private:
+    std::function<uint64_t(std::string_view)> mHashFunc;
+    std::shared_ptr<const Directory> mDirectory;
+    std::shared_ptr<std::atomic<uint64_t>> mSnapshots;
+
+   public:
+    /**
+     * @brief Construct a new Snapshot object
+     *
+     * @param hashFunc The hashing function of the table.
+     * @param directory The directory of the table at the time of the snapshot.
+     * @param snapshots The table's count of live snapshots, which this snapshot is counted in until it is destroyed.
+     */
+    Snapshot(std::function<uint64_t(std::string_view)> hashFunc, std::shared_ptr<const Directory> directory,
+             std::shared_ptr<std::atomic<uint64_t>> snapshots)
+        : mHashFunc(hashFunc), mDirectory(directory), mSnapshots(snapshots) {
+      this->mSnapshots->fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Snapshot(const Snapshot &other) : Snapshot(other.mHashFunc, other.mDirectory, other.mSnapshots) {}
+
+    Snapshot &operator=(Snapshot other) {
+      std::swap(this->mHashFunc, other.mHashFunc);
+      std::swap(this->mDirectory, other.mDirectory);
+      std::swap(this->mSnapshots, other.mSnapshots);
+      return *this;
+    }
+
+    ~Snapshot() {
+      // The directory goes first, so that the table never writes to anything this snapshot could still be reading.
+      this->mDirectory.reset();
+      this->mSnapshots->fetch_sub(1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Get the data stored at a given identifier when the snapshot was taken.
+     *
+     * @param identifier The identifier of the requested data.
+     * @return The data stored at the given identifier, if it exists.
+     */
+    std::optional<T> get(std::string identifier) const {
+      return search(*this->mDirectory, identifier, this->mHashFunc(identifier));
+    }
+
+    /**
+     * @brief Call a function for every entry in the snapshot.
+     *
+     * @tparam Function A callable taking the identifier, as a std::string_view, and the data of an entry.
+     * @param function The function to call.
+     */
+    template <typename Function>
+    void forEach(Function function) const {
+      for (const std::shared_ptr<Group> &group : *this->mDirectory) {
+        if (group == nullptr) continue;
+        for (uint64_t i = 0; i < groupSize; ++i)
+          for (const HashEntry<T> *entry = group->chains[i].get(); entry != nullptr; entry = entry->mNext.get())
+            function(std::string_view(entry->getIdentifier()), entry->get());
+      }
+    }
+  };
+
+  /**
+   * @brief Construct a new Cow Hash Table<buckets, T, groupSize> object
+   *
+   * @param hashFunc The hashing function to be used by this table.
+   * @param resource The memory resource that the table's directories, groups and entries are allocated from.
+   */
+  CowHashTable<buckets, T, groupSize>(std::function<uint64_t(std::string_view)> hashFunc = hash::fnv1a_64,
+                                      std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : mHashFunc(hashFunc),
+        mResource(resource),
+        mDirectory(std::allocate_shared<Directory>(std::pmr::polymorphic_allocator<Directory>(resource), GROUPS)),
+        mDirectoryGeneration(0),
+        mGeneration(0),
+        mSnapshots(std::allocate_shared<std::atomic<uint64_t>>(
+            std::pmr::polymorphic_allocator<std::atomic<uint64_t>>(resource), 0)) {}
+
+  /**
+   * @brief Take a snapshot of the table.
+   *
+   * Runs in constant time. The snapshot keeps every group it refers to alive until it is destroyed.
+   *
+   * @return A read-only view of the current contents of the table.
+   */
+  Snapshot snapshot() const {
+    Snapshot snapshot(this->mHashFunc, this->mDirectory, this->mSnapshots);
+    ++this->mGeneration;
+    return snapshot;
+  }
+
+  /**
+   * @brief Get the data stored at a given identifier.
+   *
+   * @param identifier The identifier of the requested data.
+   * @return The data stored at the given identifier, if it exists.
+   */
+  std::optional<T> get(std::string identifier) const {
+    return search(*this->mDirectory, identifier, this->mHashFunc(identifier));
+  }
+
+  /**
+   * @brief Set the data stored at an identifier.
+   *
+   * Will create a new table entry if one does not already exist.
+   * If an entry with the given identifier already exists, its data will be replaced.
+   * Snapshots taken earlier are not affected.
+   *
+   * @param identifier The identifier of the data.
+   * @param data The data to be stored.
+   */
+  void set(std::string identifier, T data) {
+    uint64_t hash = this->mHashFunc(identifier);
+    HashEntryPtr<T> &bucket = this->writableBucket(hash % buckets);
+    if (bucket != nullptr)
+      bucket->set(identifier, data, hash);
+    else
+      bucket = makeHashEntry<T>(this->mResource, identifier, data, hash);
+  }
+
+  /**
+   * @brief Remove an entry from the table.
+   *
+   * Snapshots taken earlier are not affected.
+   *
+   * @param identifier The identifier of the data to be removed.
+   * @return true if the entry was successfully removed.
+   * @return false if the identifier does not exist in the table.
+   */
+  bool remove(std::string identifier) {
+    uint64_t hash = this->mHashFunc(identifier);
+    if (!search(*this->mDirectory, identifier, hash).has_value()) return false;
+
+    HashEntryPtr<T> &bucket = this->writableBucket(hash % buckets);
+    if (bucket->matches(identifier, hash)) {
+      HashEntryPtr<T> tmp = std::move(bucket->mNext);
+      bucket = std::move(tmp);
+      return true;
+    }
+    return bucket->remove(identifier, hash);
+  }
+};
@@ -0,0 +1,171 @@
+#include "cuckoofilter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+const double MAX_LOAD = 0.95;  ///< The fraction of slots that can be filled before inserts start to fail.
+}  // namespace
+
+CuckooFilter::CuckooFilter(uint64_t capacity, uint32_t fingerprintBits, std::function<uint64_t(std::string_view)> hashFunc)
+    : mHashFunc(hashFunc),
+      mBucketCount(std::max<uint64_t>(1, uint64_t(std::ceil(double(capacity) / (SLOTS * MAX_LOAD))))),
+      mSize(0),
+      mBits(std::min<uint32_t>(32, std::max<uint32_t>(4, fingerprintBits))),
+      mMask(uint32_t((uint64_t(1) << this->mBits) - 1)),
+      mKick(0),
+      mVictimBucket(0),
+      mVictim(0) {
+  // One spare word lets read and write always touch the word after a slot, even for the last slot.
+  this->mWords.assign((this->mBucketCount * SLOTS * this->mBits + 63) / 64 + 1, 0);
+}
+
+void CuckooFilter::locate(uint64_t hash, uint32_t &fingerprint, uint64_t &bucket) const {
+  uint64_t mixed = hash::mix64(hash);
+  fingerprint = uint32_t(mixed >> 32) & this->mMask;
+  if (fingerprint == 0) fingerprint = 1;
+  bucket = ((mixed & 0xffffffffU) * this->mBucketCount) >> 32;
+}
+
+uint64_t CuckooFilter::alternate(uint64_t bucket, uint32_t fingerprint) const {
+  // (h - i) mod n is its own inverse, so unlike the usual xor this works for any number of buckets.
+  uint64_t offset = hash::mix64(fingerprint) % this->mBucketCount;
+  return (offset + this->mBucketCount - bucket) % this->mBucketCount;
+}
+
+uint32_t CuckooFilter::read(uint64_t bucket, uint32_t slot) const {
+  uint64_t bit = (bucket * SLOTS + slot) * this->mBits;
+  uint64_t word = bit / 64, offset = bit % 64;
+  uint64_t value = this->mWords[word] >> offset;
+  if (offset + this->mBits > 64) value |= this->mWords[word + 1] << (64 - offset);
+  return uint32_t(value) & this->mMask;
+}
+
+void CuckooFilter::write(uint64_t bucket, uint32_t slot, uint32_t fingerprint) {
+  uint64_t bit = (bucket * SLOTS + slot) * this->mBits;
+  uint64_t word = bit / 64, offset = bit % 64;
+  this->mWords[word] = (this->mWords[word] & ~(uint64_t(this->mMask) << offset)) | (uint64_t(fingerprint) << offset);
+  if (offset + this->mBits > 64) {
+    uint64_t shift = 64 - offset;
+    this->mWords[word + 1] =
+        (this->mWords[word + 1] & ~(uint64_t(this->mMask) >> shift)) | (uint64_t(fingerprint) >> shift);
+  }
+}
+
+uint32_t CuckooFilter::find(uint64_t bucket, uint32_t fingerprint) const {
+  for (uint32_t slot = 0; slot < SLOTS; ++slot)
+    if (this->read(bucket, slot) == fingerprint) return slot;
+  return SLOTS;
+}
+
+void CuckooFilter::prefetch(uint64_t hash) const {
+#if defined(__GNUC__) || defined(__clang__)
+  uint32_t fingerprint;
+  uint64_t bucket;
+  this->locate(hash, fingerprint, bucket);
+  __builtin_prefetch(&this->mWords[bucket * SLOTS * this->mBits / 64]);
+  __builtin_prefetch(&this->mWords[this->alternate(bucket, fingerprint) * SLOTS * this->mBits / 64]);
+#else
+  (void)hash;
+#endif
+}
+
+bool CuckooFilter::place(uint32_t fingerprint, uint64_t bucket) {
+  for (uint32_t attempt = 0; attempt < 2; ++attempt) {
+    uint32_t slot = this->find(bucket, 0);
+    if (slot < SLOTS) {
+      this->write(bucket, slot, fingerprint);
+      ++this->mSize;
+      return true;
+    }
+    bucket = this->alternate(bucket, fingerprint);
+  }
+
+  // Both buckets are full: keep evicting a fingerprint to its other bucket until one lands in a free slot.
+  for (uint32_t kick = 0; kick < MAX_KICKS; ++kick) {
+    uint32_t slot = this->mKick++ % SLOTS;
+    uint32_t evicted = this->read(bucket, slot);
+    this->write(bucket, slot, fingerprint);
+    fingerprint = evicted;
+    bucket = this->alternate(bucket, fingerprint);
+
+    slot = this->find(bucket, 0);
+    if (slot < SLOTS) {
+      this->write(bucket, slot, fingerprint);
+      ++this->mSize;
+      return true;
+    }
+  }
+
+  // Some fingerprint is left without a slot. Keeping it aside means nothing that was inserted is lost, and the filter
+  // refuses further inserts until a removal makes room.
+  this->mVictim = fingerprint;
+  this->mVictimBucket = bucket;
+  ++this->mSize;
+  return false;
+}
+
+bool CuckooFilter::insertHash(uint64_t hash) {
+  if (this->mVictim != 0) return false;
+  uint32_t fingerprint;
+  uint64_t bucket;
+  this->locate(hash, fingerprint, bucket);
+  this->place(fingerprint, bucket);
+  return true;
+}
+
+bool CuckooFilter::containsHash(uint64_t hash) const {
+  uint32_t fingerprint;
+  uint64_t bucket;
+  this->locate(hash, fingerprint, bucket);
+  uint64_t other = this->alternate(bucket, fingerprint);
+  if (this->find(bucket, fingerprint) < SLOTS || this->find(other, fingerprint) < SLOTS) return true;
+  return this->mVictim == fingerprint && (this->mVictimBucket == bucket || this->mVictimBucket == other);
+}
+
+bool CuckooFilter::removeHash(uint64_t hash) {
+  uint32_t fingerprint;
+  uint64_t bucket;
+  this->locate(hash, fingerprint, bucket);
+  uint64_t other = this->alternate(bucket, fingerprint);
+
+  if (this->mVictim == fingerprint && (this->mVictimBucket == bucket || this->mVictimBucket == other)) {
+    this->mVictim = 0;
+    --this->mSize;
+    return true;
+  }
+
+  for (uint64_t candidate : {bucket, other}) {
+    uint32_t slot = this->find(candidate, fingerprint);
+    if (slot == SLOTS) continue;
+    this->write(candidate, slot, 0);
+    --this->mSize;
+    if (this->mVictim != 0) {
+      // A slot has opened up, so try again to place the fingerprint that was kept aside.
+      uint32_t victim = this->mVictim;
+      this->mVictim = 0;
+      --this->mSize;
+      this->place(victim, this->mVictimBucket);
+    }
+    return true;
+  }
+  return false;
+}
+
+uint64_t CuckooFilter::insertAll(const std::vector<std::string> &identifiers) {
+  uint64_t inserted = 0;
+  this->forEachHash(identifiers, [this, &inserted](size_t, uint64_t hash) { inserted += this->insertHash(hash); });
+  return inserted;
+}
+
+std::vector<bool> CuckooFilter::containsAll(const std::vector<std::string> &identifiers) const {
+  std::vector<bool> results(identifiers.size());
+  this->forEachHash(identifiers, [this, &results](size_t i, uint64_t hash) { results[i] = this->containsHash(hash); });
+  return results;
+}
+
+uint64_t CuckooFilter::removeAll(const std::vector<std::string> &identifiers) {
+  uint64_t removed = 0;
+  this->forEachHash(identifiers, [this, &removed](size_t, uint64_t hash) { removed += this->removeHash(hash); });
+  return removed;
+}
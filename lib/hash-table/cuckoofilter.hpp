@@ -0,0 +1,235 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "hash.hpp"
+
+/**
+ * @brief An approximate set of identifiers that, unlike a Bloom filter, supports removal.
+ *
+ * Each identifier is reduced to a small fingerprint that is stored in one of two candidate buckets of four slots. The
+ * second bucket is derived from the first and the fingerprint alone, so a fingerprint can be moved between its buckets
+ * without knowing the identifier it came from. Inserting into two full buckets evicts a fingerprint to its other
+ * bucket, cuckoo style, which lets the filter fill to about 95% before an insert fails. Fingerprints are bit-packed, so
+ * the filter spends exactly fingerprintBits per slot.
+ *
+ * A lookup for an absent identifier succeeds with a probability of about 8 / 2^fingerprintBits. The default of 13 bits
+ * gives about 0.1% at about 13.7 bits per entry when the filter is full to its capacity. The filter is a multiset:
+ * inserting an identifier twice stores two fingerprints, and each removal takes away one. Only identifiers that were
+ * inserted may be removed, or the fingerprint of another identifier may be removed in their place.
+ */
+class CuckooFilter {
+ public:
+  static constexpr uint32_t SLOTS = 4;  ///< The number of fingerprints in a bucket.
+
+  /**
+   * @brief Construct a new Cuckoo Filter object
+   *
+   * @param capacity The number of identifiers the filter must be able to hold.
+   * @param fingerprintBits The size of a fingerprint, between 4 and 32 bits.
+   * @param hashFunc The hashing function that identifiers are hashed with.
+   */
+  explicit CuckooFilter(uint64_t capacity, uint32_t fingerprintBits = 13,
+                        std::function<uint64_t(std::string_view)> hashFunc = hash::fnv1a_64);
+
+  /**
+   * @brief Add an identifier to the filter.
+   *
+   * @param identifier The identifier to add.
+   * @return true if the identifier was added.
+   * @return false if the filter is full. The filter is left unchanged.
+   */
+  bool insert(std::string identifier) { return this->insertHash(this->mHashFunc(identifier)); }
+
+  /**
+   * @brief Check whether an identifier may be in the filter.
+   *
+   * @param identifier The identifier to check.
+   * @return true if the identifier may have been added.
+   * @return false if the identifier is definitely not in the filter.
+   */
+  bool contains(std::string identifier) const { return this->containsHash(this->mHashFunc(identifier)); }
+
+  /**
+   * @brief Remove an identifier that was added to the filter.
+   *
+   * @param identifier The identifier to remove.
+   * @return true if a matching fingerprint was removed.
+   * @return false if no matching fingerprint was found.
+   */
+  bool remove(std::string identifier) { return this->removeHash(this->mHashFunc(identifier)); }
+
+  /**
+   * @brief Add an identifier to the filter by its hash.
+   *
+   * @param hash The hash of the identifier, from the filter's hashing function.
+   * @return true if the identifier was added.
+   * @return false if the filter is full.
+   */
+  bool insertHash(uint64_t hash);
+
+  /**
+   * @brief Check whether an identifier may be in the filter, by its hash.
+   *
+   * @param hash The hash of the identifier, from the filter's hashing function.
+   * @return true if the identifier may have been added.
+   * @return false if the identifier is definitely not in the filter.
+   */
+  bool containsHash(uint64_t hash) const;
+
+  /**
+   * @brief Remove an identifier that was added to the filter, by its hash.
+   *
+   * @param hash The hash of the identifier, from the filter's hashing function.
+   * @return true if a matching fingerprint was removed.
+   * @return false if no matching fingerprint was found.
+   */
+  bool removeHash(uint64_t hash);
+
+  /**
+   * @brief Add several identifiers to the filter.
+   *
+   * Hashes every identifier first and prefetches buckets a few identifiers ahead, so the cache misses of the batch
+   * overlap instead of being paid one after another.
+   *
+   * @param identifiers The identifiers to add.
+   * @return The number of identifiers that were added, which is less than requested once the filter is full.
+   */
+  uint64_t insertAll(const std::vector<std::string> &identifiers);
+
+  /**
+   * @brief Check whether each of several identifiers may be in the filter.
+   *
+   * @param identifiers The identifiers to check.
+   * @return For each identifier, whether it may have been added.
+   */
+  std::vector<bool> containsAll(const std::vector<std::string> &identifiers) const;
+
+  /**
+   * @brief Remove several identifiers that were added to the filter.
+   *
+   * @param identifiers The identifiers to remove.
+   * @return The number of identifiers for which a matching fingerprint was removed.
+   */
+  uint64_t removeAll(const std::vector<std::string> &identifiers);
+
+  /**
+   * @brief Get the number of fingerprints in the filter.
+   *
+   * @return The number of identifiers added and not removed.
+   */
+  uint64_t size() const { return this->mSize; }
+
+  /**
+   * @brief Get the number of buckets.
+   *
+   * @return The number of buckets in the filter.
+   */
+  uint64_t bucketCount() const { return this->mBucketCount; }
+
+  /**
+   * @brief Get the number of bytes used by the packed fingerprints.
+   *
+   * @return The size of the filter in bytes.
+   */
+  uint64_t memoryUsage() const { return this->mWords.size() * sizeof(uint64_t); }
+
+ private:
+  static constexpr uint32_t MAX_KICKS = 500;       ///< Evictions tried before an insert gives up.
+  static constexpr size_t PREFETCH_DISTANCE = 16;  ///< How far ahead of the current identifier batches prefetch.
+
+  std::function<uint64_t(std::string_view)> mHashFunc;
+  std::vector<uint64_t> mWords;
+  uint64_t mBucketCount;
+  uint64_t mSize;
+  uint32_t mBits;
+  uint32_t mMask;
+  uint32_t mKick;          ///< Picks the slot to evict, varied on every eviction.
+  uint64_t mVictimBucket;  ///< The bucket of a fingerprint that could not be placed after MAX_KICKS.
+  uint32_t mVictim;        ///< That fingerprint, or 0 if there is none, in which case the filter is not full.
+
+  /**
+   * @brief Split a hash into a fingerprint and the index of its first bucket.
+   *
+   * @param hash The hash of an identifier.
+   * @param fingerprint Set to the fingerprint of the identifier, which is never 0.
+   * @param bucket Set to the first candidate bucket.
+   */
+  void locate(uint64_t hash, uint32_t &fingerprint, uint64_t &bucket) const;
+
+  /**
+   * @brief Get the other candidate bucket of a fingerprint.
+   *
+   * @param bucket One candidate bucket of the fingerprint.
+   * @param fingerprint The fingerprint.
+   * @return The other candidate bucket.
+   */
+  uint64_t alternate(uint64_t bucket, uint32_t fingerprint) const;
+
+  /**
+   * @brief Read the fingerprint in a slot.
+   *
+   * @param bucket The bucket of the slot.
+   * @param slot The slot in the bucket.
+   * @return The fingerprint, or 0 if the slot is empty.
+   */
+  uint32_t read(uint64_t bucket, uint32_t slot) const;
+
+  /**
+   * @brief Write a fingerprint into a slot.
+   *
+   * @param bucket The bucket of the slot.
+   * @param slot The slot in the bucket.
+   * @param fingerprint The fingerprint, or 0 to empty the slot.
+   */
+  void write(uint64_t bucket, uint32_t slot, uint32_t fingerprint);
+
+  /**
+   * @brief Check whether a bucket holds a fingerprint.
+   *
+   * @param bucket The bucket to search.
+   * @param fingerprint The fingerprint to search for.
+   * @return The slot holding the fingerprint, or SLOTS if it is not in the bucket.
+   */
+  uint32_t find(uint64_t bucket, uint32_t fingerprint) const;
+
+  /**
+   * @brief Store a fingerprint in one of its buckets, evicting other fingerprints as needed.
+   *
+   * @param fingerprint The fingerprint to store.
+   * @param bucket One candidate bucket of the fingerprint.
+   * @return true if every fingerprint found a slot.
+   * @return false if one was kept aside as the victim, which makes the filter full.
+   */
+  bool place(uint32_t fingerprint, uint64_t bucket);
+
+  /**
+   * @brief Hint to the CPU that both candidate buckets of a hash are about to be accessed.
+   *
+   * @param hash The hash of an identifier.
+   */
+  void prefetch(uint64_t hash) const;
+
+  /**
+   * @brief Hash a batch of identifiers and call a function for each hash, prefetching the buckets of later ones.
+   *
+   * @tparam Function A callable taking the position of an identifier in the batch and its hash.
+   * @param identifiers The batch of identifiers.
+   * @param function The function to call.
+   */
+  template <typename Function>
+  void forEachHash(const std::vector<std::string> &identifiers, Function function) const {
+    std::vector<uint64_t> hashes(identifiers.size());
+    for (size_t i = 0; i < identifiers.size(); ++i) hashes[i] = this->mHashFunc(identifiers[i]);
+    for (size_t i = 0; i < hashes.size() && i < PREFETCH_DISTANCE; ++i) this->prefetch(hashes[i]);
+    for (size_t i = 0; i < hashes.size(); ++i) {
+      if (i + PREFETCH_DISTANCE < hashes.size()) this->prefetch(hashes[i + PREFETCH_DISTANCE]);
+      function(i, hashes[i]);
+    }
+  }
+};
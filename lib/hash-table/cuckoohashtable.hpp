@@ -0,0 +1,438 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "hash.hpp"
+
+/**
+ * @brief A bucketized cuckoo hash table.
+ *
+ * Every identifier has exactly two candidate buckets, both derived from its hash, and each bucket holds up to two
+ * entries. Entries are stored in their bucket: the full hash, the data, and the identifier itself if it is at most
+ * INLINE_KEY bytes long. When the data is at most eight bytes, a bucket fits in a single cache line, so looking up a
+ * short identifier reads at most two cache lines, one per candidate bucket. Longer identifiers are copied to the
+ * memory resource and only read once their full hash has matched, and larger data makes a bucket span more lines.
+ * Four entries per bucket would take two cache lines each, while two entries per bucket still let the table fill to
+ * about 90% before it has to grow.
+ *
+ * When both buckets of a new identifier are full, a breadth-first search finds the shortest chain of entries that can
+ * be moved to their other bucket to make room. If there is none, the table doubles in size; entries are re-placed
+ * using their stored hashes, so identifiers are never hashed again.
+ *
+ * Entries whose buckets are both full while the table is still mostly empty can only be caused by many identifiers
+ * sharing a hash, which growing would not fix. Up to STASH_SIZE of them are kept in an overflow stash, which is only
+ * searched when it is not empty. Once the stash is full, such identifiers are refused.
+ *
+ * @tparam T The type of data to be stored in the table.
+ */
+template <typename T>
+class CuckooHashTable {
+ public:
+  static constexpr uint32_t SLOTS = 2;         ///< Entries per bucket.
+  static constexpr uint32_t INLINE_KEY = 15;   ///< The longest identifier that is stored in its bucket.
+  static constexpr uint32_t STASH_SIZE = 8;    ///< Entries that fit in neither bucket and are kept aside instead.
+
+ private:
+  static constexpr uint8_t EMPTY = 0xff;       ///< The size of the key of an unused slot.
+  static constexpr uint8_t LONG_KEY = 0xfe;    ///< The size of a key that is stored in the memory resource.
+  static constexpr uint32_t MAX_SEARCH = 512;
+  static constexpr uint64_t STASHED = UINT64_MAX;
+
+  /**
+   * @brief An identifier, stored inline if it is short, and otherwise as a pointer to a copy in the memory resource.
+   *
+   * A copy starts with the length of the identifier as a uint64_t, followed by its characters.
+   */
+  struct Key {
+    char bytes[INLINE_KEY];
+    uint8_t size = EMPTY;  ///< The length of an inline identifier, LONG_KEY or EMPTY.
+  };
+
+  /**
+   * @brief A bucket of entries, which fills one cache line when T is at most eight bytes.
+   */
+  struct alignas(64) Bucket {
+    uint64_t hashes[SLOTS] = {0, 0};
+    Key keys[SLOTS];
+    T data[SLOTS]{};
+  };
+
+  /**
+   * @brief An entry outside of the buckets, either in the stash or on its way to a new bucket.
+   */
+  struct Stashed {
+    uint64_t hash;
+    Key key;
+    T data;
+  };
+
+  /**
+   * @brief Where an entry is stored.
+   */
+  struct Position {
+    uint64_t bucket;  ///< The index of the bucket, or STASHED.
+    uint32_t slot;    ///< The slot in the bucket, or the position in the stash.
+  };
+
+  /**
+   * @brief A bucket visited by the breadth-first search for a free slot.
+   */
+  struct SearchNode {
+    uint64_t bucket;
+    int32_t parent;
+    uint32_t parentSlot;
+  };
+
+  std::function<uint64_t(std::string_view)> mHashFunc;
+  std::pmr::memory_resource *mResource;
+  std::pmr::vector<Bucket> mBuckets;
+  std::pmr::vector<Stashed> mStash;
+  uint64_t mMask;
+  uint64_t mSize;
+
+  /**
+   * @brief Get the first candidate bucket of a hash.
+   *
+   * @param hash The full hash of an identifier.
+   * @return The index of the first bucket.
+   */
+  uint64_t primary(uint64_t hash) const { return hash & this->mMask; }
+
+  /**
+   * @brief Get the second candidate bucket of a hash.
+   *
+   * Derived from the same hash with the MurmurHash3 finalizer, so it is independent of the first bucket.
+   *
+   * @param hash The full hash of an identifier.
+   * @return The index of the second bucket.
+   */
+  uint64_t secondary(uint64_t hash) const { return hash::mix64(hash) & this->mMask; }
+
+  /**
+   * @brief Get the candidate bucket of a hash that is not the given one.
+   *
+   * @param bucket One of the candidate buckets of the hash.
+   * @param hash The full hash of an identifier.
+   * @return The index of the other bucket.
+   */
+  uint64_t alternate(uint64_t bucket, uint64_t hash) const {
+    uint64_t first = this->primary(hash);
+    return bucket == first ? this->secondary(hash) : first;
+  }
+
+  /**
+   * @brief Get the identifier a key holds.
+   *
+   * @param key A key that is in use.
+   * @return The identifier.
+   */
+  static std::string_view view(const Key &key) {
+    if (key.size != LONG_KEY) return std::string_view(key.bytes, key.size);
+    const char *copy;
+    uint64_t length;
+    std::memcpy(&copy, key.bytes, sizeof(copy));
+    std::memcpy(&length, copy, sizeof(length));
+    return std::string_view(copy + sizeof(length), length);
+  }
+
+  /**
+   * @brief Make the key of an identifier, copying the identifier to the memory resource if it is too long to inline.
+   *
+   * @param identifier The identifier.
+   * @return The key, which must be released with release once it is no longer stored.
+   */
+  Key makeKey(std::string_view identifier) {
+    Key key;
+    if (identifier.size() <= INLINE_KEY) {
+      identifier.copy(key.bytes, identifier.size());
+      key.size = uint8_t(identifier.size());
+      return key;
+    }
+    uint64_t length = identifier.size();
+    char *copy = static_cast<char *>(this->mResource->allocate(sizeof(length) + length, alignof(uint64_t)));
+    std::memcpy(copy, &length, sizeof(length));
+    identifier.copy(copy + sizeof(length), length);
+    std::memcpy(key.bytes, &copy, sizeof(copy));
+    key.size = LONG_KEY;
+    return key;
+  }
+
+  /**
+   * @brief Return the copy of a long identifier to the memory resource, and mark the key as unused.
+   *
+   * @param key The key to release.
+   */
+  void release(Key &key) {
+    if (key.size == LONG_KEY) {
+      std::string_view identifier = view(key);
+      this->mResource->deallocate(const_cast<char *>(identifier.data()) - sizeof(uint64_t),
+                                  sizeof(uint64_t) + identifier.size(), alignof(uint64_t));
+    }
+    key.size = EMPTY;
+  }
+
+  /**
+   * @brief Find the entry holding an identifier.
+   *
+   * @param identifier The identifier to search for.
+   * @param hash The full hash of the identifier.
+   * @return The position of the entry, if the identifier is in the table.
+   */
+  std::optional<Position> find(std::string_view identifier, uint64_t hash) const {
+    uint64_t candidates[2] = {this->primary(hash), this->secondary(hash)};
+    for (uint64_t index : candidates) {
+      const Bucket &bucket = this->mBuckets[index];
+      for (uint32_t s = 0; s < SLOTS; ++s)
+        if (bucket.hashes[s] == hash && bucket.keys[s].size != EMPTY && view(bucket.keys[s]) == identifier)
+          return Position{index, s};
+    }
+    for (uint32_t i = 0; i < this->mStash.size(); ++i)
+      if (this->mStash[i].hash == hash && view(this->mStash[i].key) == identifier) return Position{STASHED, i};
+    return std::nullopt;
+  }
+
+  /**
+   * @brief Get the data of an entry.
+   *
+   * @param position The position of the entry.
+   * @return The data stored in the entry.
+   */
+  T &dataAt(Position position) {
+    if (position.bucket == STASHED) return this->mStash[position.slot].data;
+    return this->mBuckets[position.bucket].data[position.slot];
+  }
+
+  /**
+   * @brief Place an entry into one of its candidate buckets, moving other entries out of the way if needed.
+   *
+   * @param hash The full hash of the entry's identifier.
+   * @param key The key of the entry, which the bucket takes over if the entry is placed.
+   * @param data The data of the entry, which is moved from if the entry is placed.
+   * @return true if the entry was placed.
+   * @return false if no free slot could be reached, in which case nothing was moved.
+   */
+  bool place(uint64_t hash, const Key &key, T &data) {
+    std::vector<SearchNode> nodes;
+    nodes.push_back({this->primary(hash), -1, 0});
+    if (this->secondary(hash) != this->primary(hash)) nodes.push_back({this->secondary(hash), -1, 0});
+
+    for (size_t n = 0; n < nodes.size(); ++n) {
+      Bucket &bucket = this->mBuckets[nodes[n].bucket];
+      for (uint32_t s = 0; s < SLOTS; ++s) {
+        if (bucket.keys[s].size != EMPTY) continue;
+
+        // Walk back to the root, moving each entry on the path into the slot freed below it.
+        int32_t node = n;
+        uint32_t freeSlot = s;
+        while (nodes[node].parent >= 0) {
+          Bucket &to = this->mBuckets[nodes[node].bucket];
+          Bucket &from = this->mBuckets[nodes[nodes[node].parent].bucket];
+          to.hashes[freeSlot] = from.hashes[nodes[node].parentSlot];
+          to.keys[freeSlot] = from.keys[nodes[node].parentSlot];
+          to.data[freeSlot] = std::move(from.data[nodes[node].parentSlot]);
+          freeSlot = nodes[node].parentSlot;
+          node = nodes[node].parent;
+        }
+        Bucket &root = this->mBuckets[nodes[node].bucket];
+        root.hashes[freeSlot] = hash;
+        root.keys[freeSlot] = key;
+        root.data[freeSlot] = std::move(data);
+        return true;
+      }
+
+      for (uint32_t s = 0; s < SLOTS && nodes.size() < MAX_SEARCH; ++s) {
+        uint64_t next = this->alternate(nodes[n].bucket, bucket.hashes[s]);
+        bool visited = false;
+        for (const SearchNode &node : nodes) visited = visited || node.bucket == next;
+        if (!visited) nodes.push_back({next, static_cast<int32_t>(n), s});
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Check whether the table is less than half full.
+   *
+   * @return true if fewer than half of all slots are in use.
+   */
+  bool sparse() const { return this->mSize * 2 < this->mBuckets.size() * SLOTS; }
+
+  /**
+   * @brief Move every entry out of the buckets and the stash.
+   *
+   * @param entries Receives the entries.
+   */
+  void drain(std::pmr::vector<Stashed> &entries) {
+    for (Bucket &bucket : this->mBuckets)
+      for (uint32_t s = 0; s < SLOTS; ++s)
+        if (bucket.keys[s].size != EMPTY)
+          entries.push_back(Stashed{bucket.hashes[s], bucket.keys[s], std::move(bucket.data[s])});
+    for (Stashed &stashed : this->mStash) entries.push_back(std::move(stashed));
+    this->mStash.clear();
+  }
+
+  /**
+   * @brief Rebuild the table with at least twice as many buckets, re-placing every entry using its stored hash.
+   */
+  void grow() {
+    uint64_t bucketCount = this->mBuckets.size() * 2;
+    while (true) {
+      std::pmr::vector<Stashed> entries(this->mResource);
+      this->drain(entries);
+      this->mBuckets.assign(bucketCount, Bucket());
+      this->mMask = bucketCount - 1;
+
+      size_t i = 0;
+      for (; i < entries.size(); ++i) {
+        if (this->place(entries[i].hash, entries[i].key, entries[i].data)) continue;
+        if (!this->sparse() || this->mStash.size() == STASH_SIZE) break;
+        this->mStash.push_back(std::move(entries[i]));
+      }
+      if (i == entries.size()) return;
+      // Parked in the stash only until the next, larger attempt drains it again.
+      for (; i < entries.size(); ++i) this->mStash.push_back(std::move(entries[i]));
+      bucketCount *= 2;
+    }
+  }
+
+  /**
+   * @brief Store a new entry, growing the table if there is no room for it.
+   *
+   * @param identifier The identifier of the entry, which must not be in the table yet.
+   * @param hash The full hash of the identifier.
+   * @param data The data of the entry.
+   * @return true if the entry was stored.
+   * @return false if its buckets and the stash are full of identifiers that share its hash.
+   */
+  bool insert(std::string_view identifier, uint64_t hash, T &data) {
+    Key key = this->makeKey(identifier);
+    ++this->mSize;
+    while (!this->place(hash, key, data)) {
+      if (!this->sparse()) {
+        this->grow();
+      } else if (this->mStash.size() < STASH_SIZE) {
+        this->mStash.push_back(Stashed{hash, key, std::move(data)});
+        return true;
+      } else {
+        --this->mSize;
+        this->release(key);
+        return false;
+      }
+    }
+    return true;
+  }
+
+ public:
+  /**
+   * @brief Construct a new Cuckoo Hash Table<T> object
+   *
+   * @param hashFunc The hashing function to be used by this table.
+   * @param resource The memory resource that all of the table's memory is allocated from.
+   */
+  CuckooHashTable<T>(std::function<uint64_t(std::string_view)> hashFunc = hash::fnv1a_64,
+                     std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : mHashFunc(hashFunc), mResource(resource), mBuckets(8, resource), mStash(resource), mMask(7), mSize(0) {}
+
+  CuckooHashTable<T>(const CuckooHashTable<T> &) = delete;
+  CuckooHashTable<T> &operator=(const CuckooHashTable<T> &) = delete;
+
+  ~CuckooHashTable<T>() {
+    for (Bucket &bucket : this->mBuckets)
+      for (Key &key : bucket.keys) this->release(key);
+    for (Stashed &stashed : this->mStash) this->release(stashed.key);
+  }
+
+  /**
+   * @brief Get the number of entries in the table.
+   *
+   * @return The number of entries.
+   */
+  uint64_t size() const { return this->mSize; }
+
+  /**
+   * @brief Get the number of buckets in the table.
+   *
+   * @return The number of buckets, each of which holds up to SLOTS entries.
+   */
+  uint64_t bucketCount() const { return this->mBuckets.size(); }
+
+  /**
+   * @brief Get the data stored at a given identifier.
+   *
+   * @param identifier The identifier of the requested data.
+   * @return The data stored at the given identifier, if it exists.
+   */
+  std::optional<T> get(std::string identifier) {
+    std::optional<Position> position = this->find(identifier, this->mHashFunc(identifier));
+    if (!position.has_value()) return std::nullopt;
+    return this->dataAt(*position);
+  }
+
+  /**
+   * @brief Set the data stored at an identifier.
+   *
+   * Will create a new table entry if one does not already exist.
+   * If an entry with the given identifier already exists, its data will be replaced.
+   *
+   * @param identifier The identifier of the data.
+   * @param data The data to be stored.
+   * @return true if the data was stored.
+   * @return false if the identifier is new and too many identifiers in the table share its hash.
+   */
+  bool set(std::string identifier, T data) {
+    uint64_t hash = this->mHashFunc(identifier);
+    std::optional<Position> position = this->find(identifier, hash);
+    if (position.has_value()) {
+      this->dataAt(*position) = data;
+      return true;
+    }
+    return this->insert(identifier, hash, data);
+  }
+
+  /**
+   * @brief Add a new entry to the table.
+   *
+   * @param identifier The identifier of the data that is to be added.
+   * @param data The data that is to be added.
+   * @return true if the entry is successfully created.
+   * @return false if an entry with the given identifier already exists, or if too many identifiers in the table share
+   *         its hash.
+   */
+  bool add(std::string identifier, T data) {
+    uint64_t hash = this->mHashFunc(identifier);
+    if (this->find(identifier, hash).has_value()) return false;
+    return this->insert(identifier, hash, data);
+  }
+
+  /**
+   * @brief Remove an entry from the table.
+   *
+   * @param identifier The identifier of the data to be removed.
+   * @return true if the entry was successfully removed.
+   * @return false if the identifier does not exist in the table.
+   */
+  bool remove(std::string identifier) {
+    std::optional<Position> position = this->find(identifier, this->mHashFunc(identifier));
+    if (!position.has_value()) return false;
+
+    if (position->bucket == STASHED) {
+      this->release(this->mStash[position->slot].key);
+      if (position->slot + 1 != this->mStash.size()) this->mStash[position->slot] = std::move(this->mStash.back());
+      this->mStash.pop_back();
+    } else {
+      Bucket &bucket = this->mBuckets[position->bucket];
+      this->release(bucket.keys[position->slot]);
+      bucket.data[position->slot] = T();
+    }
+    --this->mSize;
+    return true;
+  }
+};
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "hash.hpp"
+#include "hashtable.hpp"
+#include "timerwheel.hpp"
+
+/**
+ * @brief A hash table whose entries expire after a time to live.
+ *
+ * Every entry carries its own expiry time, and a TimerWheel keeps track of when entries are due. Expired entries are
+ * never returned, and they are reclaimed a few at a time as part of ordinary get, set and remove calls, so the table
+ * never needs a full scan and no single call does more than a bounded amount of cleanup.
+ *
+ * An entry keeps a single timer while it is refreshed. Setting it again with a later expiry leaves the timer alone,
+ * and when the timer fires before the entry has expired it is re-armed for the current expiry instead.
+ *
+ * @tparam buckets How many buckets are to be used in the table.
+ * @tparam T The type of data to be stored in the table.
+ */
+template <uint64_t buckets, typename T>
+class ExpiringTable {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+ private:
+  static constexpr uint64_t RECLAIM_ENTRIES = 4;  ///< Expired entries reclaimed per operation.
+  static constexpr uint64_t RECLAIM_TIMERS = 16;  ///< Due timers taken per operation, stale or not.
+  static constexpr uint64_t RECLAIM_TICKS = 64;   ///< Timer wheel ticks advanced per operation.
+
+  /**
+   * @brief The data of an entry together with its expiry time.
+   */
+  struct Record {
+    T data;
+    Clock::time_point expiry;
+    Clock::time_point timer;  ///< When the entry's timer fires, never after its expiry.
+  };
+
+  /**
+   * @brief The timer scheduled for an entry.
+   */
+  struct Expiry {
+    std::string identifier;
+    Clock::time_point expiry;
+  };
+
+  HashTable<buckets, Record> mTable;
+  TimerWheel<Expiry> mWheel;
+  std::function<Clock::time_point()> mClock;
+  Clock::duration mResolution;
+  Clock::time_point mEpoch;
+
+  /**
+   * @brief Convert a time to a timer wheel tick, rounding up so that timers never fire early.
+   *
+   * @param time The time to convert.
+   * @return The tick at or after the given time.
+   */
+  uint64_t toTick(Clock::time_point time) const {
+    if (time <= this->mEpoch) return 0;
+    return (time - this->mEpoch + this->mResolution - Clock::duration(1)) / this->mResolution;
+  }
+
+  /**
+   * @brief Advance the timer wheel and remove a bounded number of expired entries.
+   *
+   * @param now The current time.
+   * @param maxEntries The maximum number of expired entries to remove.
+   * @param maxTimers The maximum number of due timers to take, including stale ones and ones that are re-armed.
+   * @param maxTicks The maximum number of timer wheel ticks to advance.
+   * @return The number of entries that were removed.
+   */
+  uint64_t reclaim(Clock::time_point now, uint64_t maxEntries, uint64_t maxTimers, uint64_t maxTicks) {
+    this->mWheel.advance(now <= this->mEpoch ? 0 : (now - this->mEpoch) / this->mResolution, maxTicks);
+    uint64_t removed = 0;
+    for (uint64_t timers = 0; removed < maxEntries && timers < maxTimers; ++timers) {
+      std::optional<Expiry> due = this->mWheel.popDue();
+      if (!due.has_value()) break;
+      // The entry may have been removed, or been given an earlier timer, since this timer was scheduled.
+      std::optional<Record> record = this->mTable.get(due->identifier);
+      if (!record.has_value() || record->timer != due->expiry) continue;
+      if (record->expiry <= now) {
+        this->mTable.remove(due->identifier);
+        ++removed;
+      } else {
+        record->timer = record->expiry;
+        this->mWheel.schedule(this->toTick(record->expiry), Expiry{due->identifier, record->expiry});
+        this->mTable.set(due->identifier, *record);
+      }
+    }
+    return removed;
+  }
+
+ public:
+  /**
+   * @brief Construct a new Expiring Table<buckets, T> object
+   *
+   * @param hashFunc The hashing function to be used by this table.
+   * @param resolution The granularity of the timer wheel. Entries are reclaimed no sooner than their expiry, and up to
+   *                   one resolution later.
+   * @param clock The source of the current time.
+   */
+  ExpiringTable<buckets, T>(std::function<uint64_t(std::string_view)> hashFunc = hash::fnv1a_64,
+                            Clock::duration resolution = std::chrono::seconds(1),
+                            std::function<Clock::time_point()> clock = Clock::now)
+      : mTable(hashFunc), mWheel(0), mClock(clock), mResolution(resolution), mEpoch(clock()) {}
+
+  /**
+   * @brief Get the data stored at a given identifier, unless it has expired.
+   *
+   * @param identifier The identifier of the requested data.
+   * @return The data stored at the given identifier, if it exists and has not expired.
+   */
+  std::optional<T> get(std::string identifier) {
+    Clock::time_point now = this->mClock();
+    this->reclaim(now, RECLAIM_ENTRIES, RECLAIM_TIMERS, RECLAIM_TICKS);
+    std::optional<Record> record = this->mTable.get(identifier);
+    if (!record.has_value() || record->expiry <= now) return std::nullopt;
+    return record->data;
+  }
+
+  /**
+   * @brief Set the data stored at an identifier, along with when it expires.
+   *
+   * Will create a new table entry if one does not already exist.
+   * If an entry with the given identifier already exists, its data and expiry will be replaced.
+   *
+   * @param identifier The identifier of the data.
+   * @param data The data to be stored.
+   * @param ttl How long the entry lives, starting now.
+   */
+  void set(std::string identifier, T data, Clock::duration ttl) {
+    Clock::time_point now = this->mClock();
+    this->reclaim(now, RECLAIM_ENTRIES, RECLAIM_TIMERS, RECLAIM_TICKS);
+    Clock::time_point expiry = now + ttl;
+    std::optional<Record> record = this->mTable.get(identifier);
+    if (record.has_value() && record->timer <= expiry) {
+      // The pending timer fires first and is re-armed then, so renewing an entry does not add timers.
+      this->mTable.set(identifier, Record{data, expiry, record->timer});
+      return;
+    }
+    this->mTable.set(identifier, Record{data, expiry, expiry});
+    this->mWheel.schedule(this->toTick(expiry), Expiry{identifier, expiry});
+  }
+
+  /**
+   * @brief Remove an entry from the table.
+   *
+   * @param identifier The identifier of the data to be removed.
+   * @return true if the entry was removed before it expired.
+   * @return false if the identifier does not exist in the table or has already expired.
+   */
+  bool remove(std::string identifier) {
+    Clock::time_point now = this->mClock();
+    this->reclaim(now, RECLAIM_ENTRIES, RECLAIM_TIMERS, RECLAIM_TICKS);
+    std::optional<Record> record = this->mTable.get(identifier);
+    return this->mTable.remove(identifier) && record->expiry > now;
+  }
+
+  /**
+   * @brief Reclaim every entry that has expired so far.
+   *
+   * Not needed for correctness, since expired entries are never returned and are reclaimed incrementally anyway,
+   * but useful to release memory in one go, for example when the table has been idle.
+   *
+   * @return The number of entries that were removed.
+   */
+  uint64_t expire() { return this->reclaim(this->mClock(), UINT64_MAX, UINT64_MAX, UINT64_MAX); }
+
+  /**
+   * @brief Get the number of expiry timers that are still pending.
+   *
+   * Every entry has one timer. Entries that were since removed or given an earlier expiry leave a stale timer behind
+   * until the wheel reaches it.
+   *
+   * @return The number of pending timers.
+   */
+  uint64_t pendingExpiries() const { return this->mWheel.size(); }
+};
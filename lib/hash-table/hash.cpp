@@ -1,23 +1,623 @@
 #include "hash.hpp"
 
-const uint64_t FNV_OFFSET_BASIS_64 = 14695981039346656037U;
-const uint64_t FNV_PRIME_64 = 1099511628211U;
+#include <algorithm>
+#include <array>
+#include <cstring>
 
-namespace hash {
-uint64_t fnv1a_64(std::string data) {
-  uint64_t hash = FNV_OFFSET_BASIS_64;
-  for (uint32_t i = 0; i < data.length(); ++i) {
-    hash = hash ^ (data[i]);
-    hash *= FNV_PRIME_64;
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#include <immintrin.h>
+#define HASH_X86_64
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define HASH_ARM_CRC
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define HASH_INLINE inline __attribute__((always_inline))
+#define HASH_FLATTEN __attribute__((flatten))  ///< Inlines every call made by a function.
+#else
+#define HASH_INLINE inline
+#define HASH_FLATTEN
+#endif
+
+namespace {
+const uint32_t CRC32C_POLYNOMIAL = 0x82f63b78;  ///< The Castagnoli polynomial, bit-reversed.
+
+/**
+ * @brief Build the tables of slicing-by-8, where table k holds the CRC of a byte followed by k zero bytes.
+ */
+constexpr std::array<std::array<uint32_t, 256>, 8> crc32cTables() {
+  std::array<std::array<uint32_t, 256>, 8> tables{};
+  for (uint32_t byte = 0; byte < 256; ++byte) {
+    uint32_t crc = byte;
+    for (int bit = 0; bit < 8; ++bit) crc = (crc >> 1) ^ (CRC32C_POLYNOMIAL & (0 - (crc & 1)));
+    tables[0][byte] = crc;
   }
-  return hash;
+  for (size_t k = 1; k < 8; ++k)
+    for (size_t byte = 0; byte < 256; ++byte)
+      tables[k][byte] = (tables[k - 1][byte] >> 8) ^ tables[0][tables[k - 1][byte] & 0xff];
+  return tables;
+}
+constexpr std::array<std::array<uint32_t, 256>, 8> CRC32C_TABLES = crc32cTables();
+
+/**
+ * @brief Extend a CRC32C by a little-endian word, eight bytes at a time through the tables.
+ */
+struct TableCrc {
+  static uint32_t step(uint32_t crc, uint64_t word) {
+    const auto &t = CRC32C_TABLES;
+    uint32_t low = crc ^ uint32_t(word), high = uint32_t(word >> 32);
+    return t[7][low & 0xff] ^ t[6][(low >> 8) & 0xff] ^ t[5][(low >> 16) & 0xff] ^ t[4][low >> 24] ^
+           t[3][high & 0xff] ^ t[2][(high >> 8) & 0xff] ^ t[1][(high >> 16) & 0xff] ^ t[0][high >> 24];
+  }
+};
+
+#ifdef HASH_X86_64
+/**
+ * @brief Extend a CRC32C by a little-endian word with the SSE4.2 instruction.
+ */
+struct Sse42Crc {
+  __attribute__((target("sse4.2"))) static uint32_t step(uint32_t crc, uint64_t word) {
+    return uint32_t(_mm_crc32_u64(crc, word));
+  }
+};
+#endif
+
+#ifdef HASH_ARM_CRC
+/**
+ * @brief Extend a CRC32C by a little-endian word with the ARMv8 CRC instruction.
+ */
+struct ArmCrc {
+  static uint32_t step(uint32_t crc, uint64_t word) { return __crc32cd(crc, word); }
+};
+#endif
+
+/**
+ * @brief Read eight bytes as a little-endian word.
+ */
+inline uint64_t read64(const unsigned char *bytes) { return hash::Wyhash64::read64(bytes); }
+
+/**
+ * @brief Read the last one to seven bytes of an input into a word that differs for any two tails of the same length.
+ */
+inline uint64_t readTail(const unsigned char *bytes, size_t length) {
+  if (length >= 4) return hash::Wyhash64::read32(bytes) | (hash::Wyhash64::read32(bytes + length - 4) << 32);
+  return bytes[0] | (uint64_t(bytes[length >> 1]) << 8) | (uint64_t(bytes[length - 1]) << 16);
+}
+
+const size_t CRC_BLOCK = hash::Crc32c64::Stream::BLOCK;
+
+#ifdef HASH_ARM_CRC
+using PortableCrc = ArmCrc;  ///< The fastest way of extending a CRC32C that needs no check at run time.
+#else
+using PortableCrc = TableCrc;
+#endif
+
+/**
+ * @brief Set the three CRCs of hash::crc32c_64 to their starting values for a seed.
+ */
+inline void crc32cStart(uint32_t *crc, uint64_t seed) {
+  crc[0] = ~uint32_t(seed);
+  crc[1] = ~uint32_t(seed >> 32) ^ 0x9e3779b9U;
+  crc[2] = 0x7f4a7c15U;
+}
+
+/**
+ * @brief Extend the three CRCs by whole blocks of input, a word each in turn.
+ *
+ * A CRC instruction takes three cycles but a new one can start every cycle, so three CRCs keep it busy. Like the other
+ * functions templated on Crc, this is always inlined, so that the instruction of Crc inlines too when this is called
+ * from a function compiled for it.
+ */
+template <typename Crc>
+HASH_INLINE void crc32cBlocks(uint32_t *crc, const unsigned char *bytes, size_t blocks) {
+  uint32_t a = crc[0], b = crc[1], c = crc[2];
+  for (; blocks > 0; --blocks, bytes += CRC_BLOCK) {
+    a = Crc::step(a, read64(bytes));
+    b = Crc::step(b, read64(bytes + 8));
+    c = Crc::step(c, read64(bytes + 16));
+  }
+  crc[0] = a;
+  crc[1] = b;
+  crc[2] = c;
+}
+
+/**
+ * @brief Fold the last, partial block of input into the CRCs and mix them into the hash.
+ *
+ * @param crc The CRCs after every whole block.
+ * @param bytes The bytes after the last whole block.
+ * @param remaining The number of those bytes, less than a block.
+ * @param length The length of the whole input.
+ */
+template <typename Crc>
+HASH_INLINE uint64_t crc32cFinish(const uint32_t *crc, const unsigned char *bytes, size_t remaining, size_t length) {
+  uint32_t a = crc[0], b = crc[1];
+  // Every remaining word goes into both lanes, whole into a and its upper half into b. Together the two CRCs determine
+  // the word, so an input of up to eight bytes keeps all 64 bits, where a single lane would keep only 32 of them.
+  for (; remaining >= 8; bytes += 8, remaining -= 8) {
+    uint64_t word = read64(bytes);
+    a = Crc::step(a, word);
+    b = Crc::step(b, word >> 32);
+  }
+  if (remaining > 0) {
+    uint64_t word = readTail(bytes, remaining);
+    a = Crc::step(a, word);
+    b = Crc::step(b, word >> 32);
+  }
+  // Mixing in the length tells apart inputs whose tails read as the same word. CRCs are linear, so a change in the
+  // words of one lane can cancel out a change in another wherever their CRCs are combined with XOR, or fed to the same
+  // lane. Lane c is therefore multiplied in, which is not linear in the same sense.
+  uint64_t c = length >= CRC_BLOCK ? crc[2] * 0xff51afd7ed558ccdU : 0;
+  return hash::mix64((((uint64_t(a) << 32) | b) ^ (length * 0x9e3779b97f4a7c15U)) + c);
+}
+
+/**
+ * @brief Compute hash::crc32c_64 of a whole input.
+ */
+template <typename Crc>
+HASH_INLINE uint64_t crc32cHash(const unsigned char *bytes, size_t length, uint64_t seed) {
+  uint32_t crc[3];
+  crc32cStart(crc, seed);
+  size_t blocks = length / CRC_BLOCK;
+  crc32cBlocks<Crc>(crc, bytes, blocks);
+  return crc32cFinish<Crc>(crc, bytes + blocks * CRC_BLOCK, length - blocks * CRC_BLOCK, length);
+}
+
+#ifdef HASH_X86_64
+__attribute__((target("sse4.2"))) uint64_t crc32cHashSse42(const unsigned char *bytes, size_t length, uint64_t seed) {
+  return crc32cHash<Sse42Crc>(bytes, length, seed);
+}
+
+__attribute__((target("sse4.2"))) void crc32cBlocksSse42(uint32_t *crc, const unsigned char *bytes, size_t blocks) {
+  crc32cBlocks<Sse42Crc>(crc, bytes, blocks);
+}
+
+__attribute__((target("sse4.2"))) uint64_t crc32cFinishSse42(const uint32_t *crc, const unsigned char *bytes,
+                                                             size_t remaining, size_t length) {
+  return crc32cFinish<Sse42Crc>(crc, bytes, remaining, length);
 }
 
-uint64_t mod10(std::string data) {
+// Until this is initialized, during the static initialization of other files, the portable functions are used, which
+// give the same hashes.
+const bool HAS_SSE42 = __builtin_cpu_supports("sse4.2");
+#endif
+
+/**
+ * @brief Build the random word that each byte maps to in a rolling hash.
+ */
+constexpr std::array<uint64_t, 256> buzhashTable() {
+  std::array<uint64_t, 256> table{};
+  for (uint64_t byte = 0; byte < 256; ++byte) table[byte] = hash::mix64((byte + 1) * 0x9e3779b97f4a7c15U);
+  return table;
+}
+constexpr std::array<uint64_t, 256> BUZHASH_TABLE = buzhashTable();
+
+/**
+ * @brief Rotate a word to the left.
+ */
+inline uint64_t rotate(uint64_t word, unsigned bits) {
+  bits %= 64;
+  return bits == 0 ? word : (word << bits) | (word >> (64 - bits));
+}
+
+/**
+ * @brief Hash every window of k consecutive values with a cyclic polynomial.
+ *
+ * @param count The number of values.
+ * @param k The number of values in a window.
+ * @param value Maps the position of a value to its random word.
+ * @return The hash of each window.
+ */
+template <typename Value>
+std::vector<uint64_t> rollingHashes(size_t count, size_t k, Value value) {
+  if (k == 0 || count < k) return {};
+  std::vector<uint64_t> hashes(count - k + 1);
   uint64_t hash = 0;
-  for (uint32_t i = 0; i < data.length(); ++i) {
-    hash += data[i];
+  for (size_t i = 0; i < k; ++i) hash = rotate(hash, 1) ^ value(i);
+  hashes[0] = hash;
+  // The word leaving the window has been rotated k - 1 times, and one more by the rotation that admits the next value.
+  unsigned leaving = unsigned(k % 64);
+  for (size_t i = k; i < count; ++i) {
+    hash = rotate(hash, 1) ^ rotate(value(i - k), leaving) ^ value(i);
+    hashes[i - k + 1] = hash;
+  }
+  return hashes;
+}
+
+/**
+ * @brief A run of code points whose simple case folding adds the same offset, every code point or every other one.
+ */
+struct CaseRange {
+  uint32_t first;   ///< The first code point of the run.
+  int32_t delta;    ///< The offset from each code point of the run to its folding.
+  uint16_t count;   ///< The number of code points in the run.
+  uint16_t stride;  ///< 1 if every code point of the run folds, 2 if only every other one does.
+};
+
+/**
+ * @brief The simple case folding of Unicode 14.0, the mappings of status C and S in CaseFolding.txt, sorted by first.
+ */
+const CaseRange CASE_RANGES[] = {
+    {0x00041, 32, 26, 1}, {0x000b5, 775, 1, 1}, {0x000c0, 32, 23, 1}, {0x000d8, 32, 7, 1}, {0x00100, 1, 24, 2},
+    {0x00132, 1, 3, 2}, {0x00139, 1, 8, 2}, {0x0014a, 1, 23, 2}, {0x00178, -121, 1, 1}, {0x00179, 1, 3, 2},
+    {0x0017f, -268, 1, 1}, {0x00181, 210, 1, 1}, {0x00182, 1, 2, 2}, {0x00186, 206, 1, 1}, {0x00187, 1, 1, 1},
+    {0x00189, 205, 2, 1}, {0x0018b, 1, 1, 1}, {0x0018e, 79, 1, 1}, {0x0018f, 202, 1, 1}, {0x00190, 203, 1, 1},
+    {0x00191, 1, 1, 1}, {0x00193, 205, 1, 1}, {0x00194, 207, 1, 1}, {0x00196, 211, 1, 1}, {0x00197, 209, 1, 1},
+    {0x00198, 1, 1, 1}, {0x0019c, 211, 1, 1}, {0x0019d, 213, 1, 1}, {0x0019f, 214, 1, 1}, {0x001a0, 1, 3, 2},
+    {0x001a6, 218, 1, 1}, {0x001a7, 1, 1, 1}, {0x001a9, 218, 1, 1}, {0x001ac, 1, 1, 1}, {0x001ae, 218, 1, 1},
+    {0x001af, 1, 1, 1}, {0x001b1, 217, 2, 1}, {0x001b3, 1, 2, 2}, {0x001b7, 219, 1, 1}, {0x001b8, 1, 1, 1},
+    {0x001bc, 1, 1, 1}, {0x001c4, 2, 1, 1}, {0x001c5, 1, 1, 1}, {0x001c7, 2, 1, 1}, {0x001c8, 1, 1, 1},
+    {0x001ca, 2, 1, 1}, {0x001cb, 1, 9, 2}, {0x001de, 1, 9, 2}, {0x001f1, 2, 1, 1}, {0x001f2, 1, 2, 2},
+    {0x001f6, -97, 1, 1}, {0x001f7, -56, 1, 1}, {0x001f8, 1, 20, 2}, {0x00220, -130, 1, 1}, {0x00222, 1, 9, 2},
+    {0x0023a, 10795, 1, 1}, {0x0023b, 1, 1, 1}, {0x0023d, -163, 1, 1}, {0x0023e, 10792, 1, 1}, {0x00241, 1, 1, 1},
+    {0x00243, -195, 1, 1}, {0x00244, 69, 1, 1}, {0x00245, 71, 1, 1}, {0x00246, 1, 5, 2}, {0x00345, 116, 1, 1},
+    {0x00370, 1, 2, 2}, {0x00376, 1, 1, 1}, {0x0037f, 116, 1, 1}, {0x00386, 38, 1, 1}, {0x00388, 37, 3, 1},
+    {0x0038c, 64, 1, 1}, {0x0038e, 63, 2, 1}, {0x00391, 32, 17, 1}, {0x003a3, 32, 9, 1}, {0x003c2, 1, 1, 1},
+    {0x003cf, 8, 1, 1}, {0x003d0, -30, 1, 1}, {0x003d1, -25, 1, 1}, {0x003d5, -15, 1, 1}, {0x003d6, -22, 1, 1},
+    {0x003d8, 1, 12, 2}, {0x003f0, -54, 1, 1}, {0x003f1, -48, 1, 1}, {0x003f4, -60, 1, 1}, {0x003f5, -64, 1, 1},
+    {0x003f7, 1, 1, 1}, {0x003f9, -7, 1, 1}, {0x003fa, 1, 1, 1}, {0x003fd, -130, 3, 1}, {0x00400, 80, 16, 1},
+    {0x00410, 32, 32, 1}, {0x00460, 1, 17, 2}, {0x0048a, 1, 27, 2}, {0x004c0, 15, 1, 1}, {0x004c1, 1, 7, 2},
+    {0x004d0, 1, 48, 2}, {0x00531, 48, 38, 1}, {0x010a0, 7264, 38, 1}, {0x010c7, 7264, 1, 1}, {0x010cd, 7264, 1, 1},
+    {0x013f8, -8, 6, 1}, {0x01c80, -6222, 1, 1}, {0x01c81, -6221, 1, 1}, {0x01c82, -6212, 1, 1}, {0x01c83, -6210, 2, 1},
+    {0x01c85, -6211, 1, 1}, {0x01c86, -6204, 1, 1}, {0x01c87, -6180, 1, 1}, {0x01c88, 35267, 1, 1},
+    {0x01c90, -3008, 43, 1}, {0x01cbd, -3008, 3, 1}, {0x01e00, 1, 75, 2}, {0x01e9b, -58, 1, 1}, {0x01e9e, -7615, 1, 1},
+    {0x01ea0, 1, 48, 2}, {0x01f08, -8, 8, 1}, {0x01f18, -8, 6, 1}, {0x01f28, -8, 8, 1}, {0x01f38, -8, 8, 1},
+    {0x01f48, -8, 6, 1}, {0x01f59, -8, 1, 1}, {0x01f5b, -8, 1, 1}, {0x01f5d, -8, 1, 1}, {0x01f5f, -8, 1, 1},
+    {0x01f68, -8, 8, 1}, {0x01f88, -8, 8, 1}, {0x01f98, -8, 8, 1}, {0x01fa8, -8, 8, 1}, {0x01fb8, -8, 2, 1},
+    {0x01fba, -74, 2, 1}, {0x01fbc, -9, 1, 1}, {0x01fbe, -7173, 1, 1}, {0x01fc8, -86, 4, 1}, {0x01fcc, -9, 1, 1},
+    {0x01fd8, -8, 2, 1}, {0x01fda, -100, 2, 1}, {0x01fe8, -8, 2, 1}, {0x01fea, -112, 2, 1}, {0x01fec, -7, 1, 1},
+    {0x01ff8, -128, 2, 1}, {0x01ffa, -126, 2, 1}, {0x01ffc, -9, 1, 1}, {0x02126, -7517, 1, 1}, {0x0212a, -8383, 1, 1},
+    {0x0212b, -8262, 1, 1}, {0x02132, 28, 1, 1}, {0x02160, 16, 16, 1}, {0x02183, 1, 1, 1}, {0x024b6, 26, 26, 1},
+    {0x02c00, 48, 48, 1}, {0x02c60, 1, 1, 1}, {0x02c62, -10743, 1, 1}, {0x02c63, -3814, 1, 1}, {0x02c64, -10727, 1, 1},
+    {0x02c67, 1, 3, 2}, {0x02c6d, -10780, 1, 1}, {0x02c6e, -10749, 1, 1}, {0x02c6f, -10783, 1, 1},
+    {0x02c70, -10782, 1, 1}, {0x02c72, 1, 1, 1}, {0x02c75, 1, 1, 1}, {0x02c7e, -10815, 2, 1}, {0x02c80, 1, 50, 2},
+    {0x02ceb, 1, 2, 2}, {0x02cf2, 1, 1, 1}, {0x0a640, 1, 23, 2}, {0x0a680, 1, 14, 2}, {0x0a722, 1, 7, 2},
+    {0x0a732, 1, 31, 2}, {0x0a779, 1, 2, 2}, {0x0a77d, -35332, 1, 1}, {0x0a77e, 1, 5, 2}, {0x0a78b, 1, 1, 1},
+    {0x0a78d, -42280, 1, 1}, {0x0a790, 1, 2, 2}, {0x0a796, 1, 10, 2}, {0x0a7aa, -42308, 1, 1}, {0x0a7ab, -42319, 1, 1},
+    {0x0a7ac, -42315, 1, 1}, {0x0a7ad, -42305, 1, 1}, {0x0a7ae, -42308, 1, 1}, {0x0a7b0, -42258, 1, 1},
+    {0x0a7b1, -42282, 1, 1}, {0x0a7b2, -42261, 1, 1}, {0x0a7b3, 928, 1, 1}, {0x0a7b4, 1, 8, 2}, {0x0a7c4, -48, 1, 1},
+    {0x0a7c5, -42307, 1, 1}, {0x0a7c6, -35384, 1, 1}, {0x0a7c7, 1, 2, 2}, {0x0a7d0, 1, 1, 1}, {0x0a7d6, 1, 2, 2},
+    {0x0a7f5, 1, 1, 1}, {0x0ab70, -38864, 80, 1}, {0x0ff21, 32, 26, 1}, {0x10400, 40, 40, 1}, {0x104b0, 40, 36, 1},
+    {0x10570, 39, 11, 1}, {0x1057c, 39, 15, 1}, {0x1058c, 39, 7, 1}, {0x10594, 39, 2, 1}, {0x10c80, 64, 51, 1},
+    {0x118a0, 32, 32, 1}, {0x16e40, 32, 32, 1}, {0x1e900, 34, 34, 1}};
+
+/**
+ * @brief Lowercase the ASCII letters of eight ASCII bytes at once.
+ *
+ * Adding to a byte below 0x80 never carries into the next byte, so the top bit of each byte of the two sums tells
+ * whether that byte is at least 'A' and whether it is above 'Z'.
+ */
+inline uint64_t lowerAsciiWord(uint64_t word) {
+  const uint64_t ones = 0x0101010101010101U;
+  uint64_t atLeastA = word + ones * (0x80 - 'A');
+  uint64_t aboveZ = word + ones * (0x80 - 'Z' - 1);
+  return word | (((atLeastA & ~aboveZ) & ones * 0x80) >> 2);
+}
+
+inline bool isAscii(uint64_t word) { return (word & 0x8080808080808080U) == 0; }
+
+inline unsigned char lowerAscii(unsigned char byte) { return byte >= 'A' && byte <= 'Z' ? byte | 0x20 : byte; }
+
+const int TRUNCATED = 0;  ///< Returned by decode for a valid sequence that is cut off by the end of the data.
+const int INVALID = -1;   ///< Returned by decode for a byte that does not start a valid sequence.
+
+/**
+ * @brief Decode one UTF-8 sequence, rejecting overlong forms, surrogates and code points above U+10FFFF.
+ *
+ * @param bytes The sequence, which starts with a byte of at least 0x80.
+ * @param available The number of bytes left in the data.
+ * @param codePoint Set to the decoded code point.
+ * @return The length of the sequence, TRUNCATED or INVALID.
+ */
+int decode(const unsigned char *bytes, size_t available, uint32_t &codePoint) {
+  unsigned char lead = bytes[0];
+  int size;
+  unsigned char low = 0x80, high = 0xbf;  // The range of the second byte, narrowed for some leads.
+  if (lead >= 0xc2 && lead <= 0xdf) {
+    size = 2;
+    codePoint = lead & 0x1f;
+  } else if (lead >= 0xe0 && lead <= 0xef) {
+    size = 3;
+    codePoint = lead & 0x0f;
+    if (lead == 0xe0) low = 0xa0;
+    if (lead == 0xed) high = 0x9f;
+  } else if (lead >= 0xf0 && lead <= 0xf4) {
+    size = 4;
+    codePoint = lead & 0x07;
+    if (lead == 0xf0) low = 0x90;
+    if (lead == 0xf4) high = 0x8f;
+  } else {
+    return INVALID;
+  }
+  for (int i = 1; i < size; ++i) {
+    if (size_t(i) >= available) return TRUNCATED;
+    unsigned char next = bytes[i];
+    if (next < (i == 1 ? low : 0x80) || next > (i == 1 ? high : 0xbf)) return INVALID;
+    codePoint = (codePoint << 6) | (next & 0x3f);
+  }
+  return size;
+}
+
+/**
+ * @brief Encode a code point as UTF-8.
+ *
+ * @return The number of bytes written, at most four.
+ */
+size_t encode(uint32_t codePoint, char *out) {
+  if (codePoint < 0x80) {
+    out[0] = char(codePoint);
+    return 1;
+  }
+  if (codePoint < 0x800) {
+    out[0] = char(0xc0 | (codePoint >> 6));
+    out[1] = char(0x80 | (codePoint & 0x3f));
+    return 2;
+  }
+  if (codePoint < 0x10000) {
+    out[0] = char(0xe0 | (codePoint >> 12));
+    out[1] = char(0x80 | ((codePoint >> 6) & 0x3f));
+    out[2] = char(0x80 | (codePoint & 0x3f));
+    return 3;
+  }
+  out[0] = char(0xf0 | (codePoint >> 18));
+  out[1] = char(0x80 | ((codePoint >> 12) & 0x3f));
+  out[2] = char(0x80 | ((codePoint >> 6) & 0x3f));
+  out[3] = char(0x80 | (codePoint & 0x3f));
+  return 4;
+}
+
+/**
+ * @brief Read the next character of some data and fold it.
+ *
+ * @param data The data.
+ * @param position The position of the character, advanced past it.
+ * @return The folded code point, or 0x110000 plus the byte for a byte that is not part of valid UTF-8, so that the
+ *         result is equal for two characters exactly when their folded bytes are.
+ */
+uint32_t nextFolded(std::string_view data, size_t &position) {
+  const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data.data()) + position;
+  if (bytes[0] < 0x80) {
+    ++position;
+    return lowerAscii(bytes[0]);
+  }
+  uint32_t codePoint;
+  int size = decode(bytes, data.size() - position, codePoint);
+  if (size <= 0) {
+    ++position;
+    return 0x110000 + bytes[0];
+  }
+  position += size_t(size);
+  return hash::foldCodePoint(codePoint);
+}
+
+void batchScalar(const std::string_view *keys, size_t count, uint64_t *hashes) {
+  for (size_t i = 0; i < count; ++i) hashes[i] = hash::fnv1a_64(keys[i]);
+}
+
+#ifdef HASH_X86_64
+const size_t LANES = 8;  ///< 64-bit lanes in an AVX-512 register.
+
+/**
+ * @brief Read up to eight bytes of a key, starting at a position, as a little-endian word padded with zeros.
+ *
+ * The load is masked to the bytes that belong to the key, so it never touches memory past its end.
+ */
+__attribute__((target("avx512f,avx512bw,avx512vl,bmi2"))) inline uint64_t chunkAt(const std::string_view &key,
+                                                                                  size_t position) {
+  size_t remaining = key.size() > position ? key.size() - position : 0;
+  __mmask16 mask = __mmask16(_bzhi_u32(0xff, uint32_t(std::min<size_t>(remaining, 8))));
+  return uint64_t(_mm_cvtsi128_si64(_mm_maskz_loadu_epi8(mask, key.data() + position)));
+}
+
+/**
+ * @brief Read the next eight bytes of each of eight keys into the lanes of a register.
+ */
+__attribute__((target("avx512f,avx512bw,avx512vl,bmi2"))) inline __m512i chunksAt(const std::string_view *keys,
+                                                                                  size_t position) {
+  return _mm512_set_epi64(chunkAt(keys[7], position), chunkAt(keys[6], position), chunkAt(keys[5], position),
+                          chunkAt(keys[4], position), chunkAt(keys[3], position), chunkAt(keys[2], position),
+                          chunkAt(keys[1], position), chunkAt(keys[0], position));
+}
+
+/**
+ * @brief Hash keys sixteen at a time, in the lanes of two AVX-512 registers.
+ *
+ * Each step mixes one byte into every key whose length has not been reached, so a group costs as many steps as its
+ * longest key, and the two registers keep two independent chains of multiplications in flight.
+ */
+__attribute__((target("avx512f,avx512dq,avx512bw,avx512vl,bmi2"))) void batchAvx512(const std::string_view *keys,
+                                                                                    size_t count, uint64_t *hashes) {
+  const __m512i byteMask = _mm512_set1_epi64(0xff);
+  const __m512i signBit = _mm512_set1_epi64(0x80);
+  const __m512i prime = _mm512_set1_epi64(int64_t(hash::Fnv1a64::PRIME));
+  size_t i = 0;
+  for (; i + 2 * LANES <= count; i += 2 * LANES) {
+    const std::string_view *low = keys + i, *high = keys + i + LANES;
+    __m512i hashLow = _mm512_set1_epi64(int64_t(hash::Fnv1a64::OFFSET_BASIS));
+    __m512i hashHigh = hashLow;
+    __m512i lengthsLow = _mm512_set_epi64(low[7].size(), low[6].size(), low[5].size(), low[4].size(), low[3].size(),
+                                          low[2].size(), low[1].size(), low[0].size());
+    __m512i lengthsHigh = _mm512_set_epi64(high[7].size(), high[6].size(), high[5].size(), high[4].size(),
+                                           high[3].size(), high[2].size(), high[1].size(), high[0].size());
+    size_t longest = 0;
+    for (size_t lane = 0; lane < 2 * LANES; ++lane) longest = std::max(longest, low[lane].size());
+
+    for (size_t block = 0; block < longest; block += 8) {
+      __m512i chunksLow = chunksAt(low, block), chunksHigh = chunksAt(high, block);
+      size_t end = std::min(longest, block + 8);
+      for (size_t position = block; position < end; ++position) {
+        // (b ^ 0x80) - 0x80 sign-extends a byte, as fnv1a_64 does.
+        __m512i bytesLow = _mm512_sub_epi64(_mm512_xor_si512(_mm512_and_si512(chunksLow, byteMask), signBit), signBit);
+        __m512i bytesHigh =
+            _mm512_sub_epi64(_mm512_xor_si512(_mm512_and_si512(chunksHigh, byteMask), signBit), signBit);
+        chunksLow = _mm512_srli_epi64(chunksLow, 8);
+        chunksHigh = _mm512_srli_epi64(chunksHigh, 8);
+        // Lanes whose key has ended keep their hash; the others mix in their next byte.
+        __m512i step = _mm512_set1_epi64(int64_t(position));
+        hashLow = _mm512_mask_mullo_epi64(hashLow, _mm512_cmpgt_epi64_mask(lengthsLow, step),
+                                          _mm512_xor_si512(hashLow, bytesLow), prime);
+        hashHigh = _mm512_mask_mullo_epi64(hashHigh, _mm512_cmpgt_epi64_mask(lengthsHigh, step),
+                                           _mm512_xor_si512(hashHigh, bytesHigh), prime);
+      }
+    }
+    _mm512_storeu_si512(hashes + i, hashLow);
+    _mm512_storeu_si512(hashes + i + LANES, hashHigh);
+  }
+  batchScalar(keys + i, count - i, hashes + i);
+}
+
+const bool HAS_AVX512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") &&
+                        __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl") &&
+                        __builtin_cpu_supports("bmi2");
+#endif
+}  // namespace
+
+namespace hash {
+void batch(const std::string_view *keys, size_t count, uint64_t *hashes) {
+#ifdef HASH_X86_64
+  if (HAS_AVX512) return batchAvx512(keys, count, hashes);
+#endif
+  batchScalar(keys, count, hashes);
+}
+
+HASH_FLATTEN void batch128(const std::string_view *keys, size_t count, Hash128 *hashes) {
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2) {
+    // With both hashes inlined, the steps of each key run while the other waits on its multiplications.
+    Hash128 first = wyhash128(keys[i]), second = wyhash128(keys[i + 1]);
+    hashes[i] = first;
+    hashes[i + 1] = second;
   }
-  return hash % 10;
+  if (i < count) hashes[i] = wyhash128(keys[i]);
+}
+
+uint64_t Crc32c64::operator()(const void *data, size_t length, uint64_t seed) const {
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+#ifdef HASH_X86_64
+  if (HAS_SSE42) return crc32cHashSse42(bytes, length, seed);
+#endif
+  return crc32cHash<PortableCrc>(bytes, length, seed);
+}
+
+Crc32c64::Stream::Stream(uint64_t seed) : mLength(0), mPending(0) { crc32cStart(this->mCrc, seed); }
+
+void Crc32c64::Stream::update(const void *data, size_t length) {
+  if (length == 0) return;
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  this->mLength += length;
+  if (this->mPending > 0) {
+    size_t count = std::min(length, BLOCK - this->mPending);
+    std::memcpy(this->mBuffer + this->mPending, bytes, count);
+    this->mPending += count;
+    bytes += count;
+    length -= count;
+    if (this->mPending < BLOCK) return;
+    this->mPending = 0;
+    this->consume(this->mBuffer, 1);
+  }
+  this->consume(bytes, length / BLOCK);
+  this->mPending = length % BLOCK;
+  std::memcpy(this->mBuffer, bytes + length - this->mPending, this->mPending);
+}
+
+void Crc32c64::Stream::consume(const unsigned char *bytes, size_t blocks) {
+#ifdef HASH_X86_64
+  if (HAS_SSE42) return crc32cBlocksSse42(this->mCrc, bytes, blocks);
+#endif
+  crc32cBlocks<PortableCrc>(this->mCrc, bytes, blocks);
+}
+
+uint64_t Crc32c64::Stream::finalize() const {
+#ifdef HASH_X86_64
+  if (HAS_SSE42) return crc32cFinishSse42(this->mCrc, this->mBuffer, this->mPending, this->mLength);
+#endif
+  return crc32cFinish<PortableCrc>(this->mCrc, this->mBuffer, this->mPending, this->mLength);
+}
+
+uint32_t foldCodePoint(uint32_t codePoint) {
+  if (codePoint < 0x80) return lowerAscii(static_cast<unsigned char>(codePoint));
+  const CaseRange *range = std::upper_bound(std::begin(CASE_RANGES), std::end(CASE_RANGES), codePoint,
+                                            [](uint32_t value, const CaseRange &r) { return value < r.first; });
+  if (range == std::begin(CASE_RANGES)) return codePoint;
+  --range;
+  uint32_t offset = codePoint - range->first;
+  if (offset >= uint32_t(range->count) * range->stride || offset % range->stride != 0) return codePoint;
+  return uint32_t(int32_t(codePoint) + range->delta);
+}
+
+size_t foldChunk(const char *data, size_t length, char *out, size_t &written, bool final) {
+  const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+  size_t position = 0;
+  written = 0;
+  // A folded code point takes at most four bytes, so stop once four might not fit.
+  while (position < length && written + 4 <= FOLD_CHUNK) {
+    if (position + 8 <= length && written + 8 <= FOLD_CHUNK) {
+      uint64_t word;
+      std::memcpy(&word, bytes + position, 8);
+      if (isAscii(word)) {
+        word = lowerAsciiWord(word);
+        std::memcpy(out + written, &word, 8);
+        position += 8;
+        written += 8;
+        continue;
+      }
+    }
+    if (bytes[position] < 0x80) {
+      out[written++] = char(lowerAscii(bytes[position++]));
+      continue;
+    }
+    uint32_t codePoint;
+    int size = decode(bytes + position, length - position, codePoint);
+    if (size == TRUNCATED && !final) break;
+    if (size <= 0) {
+      out[written++] = char(bytes[position++]);
+      continue;
+    }
+    written += encode(foldCodePoint(codePoint), out + written);
+    position += size_t(size);
+  }
+  return position;
+}
+
+std::string foldCase(std::string_view data) {
+  std::string folded;
+  folded.reserve(data.size());
+  char buffer[FOLD_CHUNK];
+  while (!data.empty()) {
+    size_t written = 0;
+    data.remove_prefix(foldChunk(data.data(), data.size(), buffer, written));
+    folded.append(buffer, written);
+  }
+  return folded;
+}
+
+bool equalIgnoringCase(std::string_view a, std::string_view b) {
+  size_t i = 0, j = 0;
+  while (i < a.size() && j < b.size()) {
+    if (i + 8 <= a.size() && j + 8 <= b.size()) {
+      uint64_t wordA, wordB;
+      std::memcpy(&wordA, a.data() + i, 8);
+      std::memcpy(&wordB, b.data() + j, 8);
+      if (isAscii(wordA) && isAscii(wordB)) {
+        if (lowerAsciiWord(wordA) != lowerAsciiWord(wordB)) return false;
+        i += 8;
+        j += 8;
+        continue;
+      }
+    }
+    if (nextFolded(a, i) != nextFolded(b, j)) return false;
+  }
+  return i == a.size() && j == b.size();
+}
+
+std::vector<uint64_t> kgrams(std::string_view data, size_t k) {
+  return rollingHashes(data.size(), k, [data](size_t i) { return BUZHASH_TABLE[uint8_t(data[i])]; });
+}
+
+std::vector<uint64_t> shingles(const std::vector<uint64_t> &tokens, size_t k) {
+  return rollingHashes(tokens.size(), k, [&tokens](size_t i) { return mix64(tokens[i]); });
 }
-}  // namespace hash
\ No newline at end of file
+}  // namespace hash
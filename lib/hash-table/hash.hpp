@@ -1,10 +1,36 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <functional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 /**
  * @brief Hash functions that can be used for a hash table.
+ * 
+ * Each hash function can hash either a std::string_view, which std::string and string literals convert to without a
+ * copy, or a raw span of bytes given as a pointer and a length, such as part of a memory-mapped message. Hash functions
+ * are function objects rather than sets of overloaded functions, so they can still be passed by name wherever a
+ * hashing function is expected, as in HashTable<buckets, T>(hash::mod10).
+ * 
+ * Each hash function also has a Stream, which computes the same hash from data given in pieces, so a token can be
+ * hashed while it is being decoded without first being copied into a string:
+ * 
+ *     hash::Fnv1a64::Stream stream;
+ *     stream.update(firstPiece);
+ *     stream.update(secondPiece);
+ *     uint64_t hash = stream.finalize();
+ * 
+ * Hash functions are constexpr when given a std::string_view, so hashes of known strings can be computed at compile time,
+ * for example to switch on header names. The _h literal in hash::literals is shorthand for hash::fnv1a_64:
+ * 
+ *     using namespace hash::literals;
+ *     switch (hash::fnv1a_64(name)) {
+ *       case "Subject"_h: ...
+ *     }
  */
 namespace hash {
 
@@ -14,10 +40,71 @@ namespace hash {
  * The Fowler-Noll-Vo hash function is simple and efficient algorithm that distributes hashes evenly.
  * For more information, see https://en.wikipedia.org/wiki/Fowler%E2%80%93Noll%E2%80%93Vo_hash_function#FNV-1a_hash
  * 
- * @param data The data, in string form, that is to be hashed.
- * @return A 64-bit unsigned integer that represents the hash of the data.
+ * Bytes are sign-extended before they are mixed in, as they always have been here, so hashes of data with bytes above
+ * 0x7f differ from the reference FNV-1a. Changing that would invalidate every hash already stored in a saved table.
  */
-uint64_t fnv1a_64(std::string data);
+struct Fnv1a64 {
+  static constexpr uint64_t OFFSET_BASIS = 14695981039346656037U;
+  static constexpr uint64_t PRIME = 1099511628211U;
+
+  /**
+   * @param data The data, in string form, that is to be hashed.
+   * @return A 64-bit unsigned integer that represents the hash of the data.
+   */
+  constexpr uint64_t operator()(std::string_view data) const {
+    Stream stream;
+    stream.update(data);
+    return stream.finalize();
+  }
+
+  /**
+   * @param data The bytes that are to be hashed.
+   * @param length The number of bytes.
+   * @return A 64-bit unsigned integer that represents the hash of the data.
+   */
+  uint64_t operator()(const void *data, size_t length) const {
+    return (*this)(std::string_view(static_cast<const char *>(data), length));
+  }
+
+  /**
+   * @brief Computes the same hash as fnv1a_64 from data given in pieces, for example while it is being decoded.
+   */
+  class Stream {
+   public:
+    /**
+     * @brief Add the next piece of the data.
+     * 
+     * @param data The data, in string form, that follows the data added so far.
+     */
+    constexpr void update(std::string_view data) {
+      for (size_t i = 0; i < data.size(); ++i) {
+        this->mHash = this->mHash ^ (data[i]);
+        this->mHash *= PRIME;
+      }
+    }
+
+    /**
+     * @brief Add the next piece of the data.
+     * 
+     * @param data The bytes that follow the ones added so far.
+     * @param length The number of bytes.
+     */
+    void update(const void *data, size_t length) {
+      this->update(std::string_view(static_cast<const char *>(data), length));
+    }
+
+    /**
+     * @brief Get the hash of all the data added so far. More data may still be added afterwards.
+     * 
+     * @return The hash that fnv1a_64 returns for the concatenated data.
+     */
+    constexpr uint64_t finalize() const { return this->mHash; }
+
+   private:
+    uint64_t mHash = OFFSET_BASIS;
+  };
+};
+inline constexpr Fnv1a64 fnv1a_64{};
 
 /**
  * @brief A simple hash algorithm used for testing.
@@ -25,9 +112,751 @@ uint64_t fnv1a_64(std::string data);
  * Simply sums the characters in data and mods that sum by 10.
  * This algorithm is designed to have many collisions in order to more easily test the hash table.
  * Should not be used for a production hash table.
+ */
+struct Mod10 {
+  /**
+   * @param data The data, in string form, that is to be hashed.
+   * @return A 64-bit unsigned integer that represents the hash of the data. 
+   */
+  constexpr uint64_t operator()(std::string_view data) const {
+    Stream stream;
+    stream.update(data);
+    return stream.finalize();
+  }
+
+  /**
+   * @param data The bytes that are to be hashed.
+   * @param length The number of bytes.
+   * @return A 64-bit unsigned integer that represents the hash of the data. 
+   */
+  uint64_t operator()(const void *data, size_t length) const {
+    return (*this)(std::string_view(static_cast<const char *>(data), length));
+  }
+
+  /**
+   * @brief Computes the same hash as mod10 from data given in pieces.
+   */
+  class Stream {
+   public:
+    /**
+     * @brief Add the next piece of the data.
+     * 
+     * @param data The data, in string form, that follows the data added so far.
+     */
+    constexpr void update(std::string_view data) {
+      for (size_t i = 0; i < data.size(); ++i) {
+        this->mSum += data[i];
+      }
+    }
+
+    /**
+     * @brief Add the next piece of the data.
+     * 
+     * @param data The bytes that follow the ones added so far.
+     * @param length The number of bytes.
+     */
+    void update(const void *data, size_t length) {
+      this->update(std::string_view(static_cast<const char *>(data), length));
+    }
+
+    /**
+     * @brief Get the hash of all the data added so far. More data may still be added afterwards.
+     * 
+     * @return The hash that mod10 returns for the concatenated data.
+     */
+    constexpr uint64_t finalize() const { return this->mSum % 10; }
+
+   private:
+    uint64_t mSum = 0;
+  };
+};
+inline constexpr Mod10 mod10{};
+
+/**
+ * @brief Hash many keys with fnv1a_64 at once.
+ * 
+ * On x86 CPUs with AVX-512, chosen at run time, sixteen keys are hashed side by side in the 64-bit lanes of two vector
+ * registers, a byte of every key per step, which hashes short keys such as the tokens of a message about a third
+ * faster than one at a time. Keys of very different lengths in the same group of sixteen waste some of that, since a
+ * group takes as many steps as its longest key. Elsewhere the keys are hashed one after another. Either way every hash
+ * is exactly what fnv1a_64 returns for its key, so batch hashes can be used with tables that hash with fnv1a_64.
+ * 
+ * @param keys The keys that are to be hashed.
+ * @param count The number of keys.
+ * @param hashes Receives the hash of each key, in the same order. Must have room for count hashes.
+ */
+void batch(const std::string_view *keys, size_t count, uint64_t *hashes);
+
+/**
+ * @brief A fast 64-bit hash in the style of wyhash that reads its input eight bytes at a time.
+ * 
+ * FNV-1a needs one multiplication per byte, which limits it to around 1 GB/s. This hash follows the construction of
+ * wyhash (final version 4): long inputs are consumed 48 bytes per round in three independent lanes, and every step folds
+ * two 64-bit words together with a full 64x64-to-128-bit multiplication, which mixes well enough that keys of any
+ * length, including very short ones, avalanche fully. Words are read as little-endian on every platform, so hashes are
+ * portable, but they are not checked against the reference implementation and should not be assumed to match it.
+ */
+struct Wyhash64 {
+  static constexpr uint64_t SECRET[4] = {0x2d358dccaa6c78a5U, 0x8bb84b93962eacc9U, 0x4b33a62ed433d4a3U,
+                                         0x4d5a2da51de1aa47U};
+
+  /**
+   * @brief Multiply two words into a 128-bit product and return its low and high halves.
+   */
+  static void multiply(uint64_t &a, uint64_t &b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t product = static_cast<__uint128_t>(a) * b;
+    a = static_cast<uint64_t>(product);
+    b = static_cast<uint64_t>(product >> 64);
+#else
+    uint64_t aHigh = a >> 32, aLow = uint32_t(a), bHigh = b >> 32, bLow = uint32_t(b);
+    uint64_t high = aHigh * bHigh, middle0 = aHigh * bLow, middle1 = aLow * bHigh, low = aLow * bLow;
+    uint64_t carry = ((low >> 32) + uint32_t(middle0) + uint32_t(middle1)) >> 32;
+    a = low + (middle0 << 32) + (middle1 << 32);
+    b = high + (middle0 >> 32) + (middle1 >> 32) + carry;
+#endif
+  }
+
+  /**
+   * @brief Fold two words into one through their 128-bit product.
+   */
+  static uint64_t mix(uint64_t a, uint64_t b) {
+    multiply(a, b);
+    return a ^ b;
+  }
+
+  /**
+   * @brief Read eight bytes as a little-endian word.
+   */
+  static uint64_t read64(const unsigned char *bytes) {
+    uint64_t word;
+    std::memcpy(&word, bytes, sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    return word;
+  }
+
+  /**
+   * @brief Read four bytes as a little-endian word.
+   */
+  static uint64_t read32(const unsigned char *bytes) {
+    uint32_t word;
+    std::memcpy(&word, bytes, sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap32(word);
+#endif
+    return word;
+  }
+
+  /**
+   * @brief Turn a seed into the starting state of a hash.
+   */
+  static uint64_t start(uint64_t seed) { return seed ^ mix(seed ^ SECRET[0], SECRET[1]); }
+
+  /**
+   * @brief Read an input of at most 16 bytes into the two words that finish folds together.
+   */
+  static void readShort(const unsigned char *bytes, size_t length, uint64_t &a, uint64_t &b) {
+    if (length >= 4) {
+      // Two overlapping pairs of four-byte reads cover every length from 4 to 16 without a loop.
+      size_t offset = (length >> 3) << 2;
+      a = (read32(bytes) << 32) | read32(bytes + offset);
+      b = (read32(bytes + length - 4) << 32) | read32(bytes + length - 4 - offset);
+    } else if (length > 0) {
+      a = (uint64_t(bytes[0]) << 16) | (uint64_t(bytes[length >> 1]) << 8) | bytes[length - 1];
+    }
+  }
+
+  /**
+   * @brief Fold the last two words of an input and its length into the hash.
+   */
+  static uint64_t finish(uint64_t a, uint64_t b, uint64_t seed, size_t length) {
+    a ^= SECRET[1];
+    b ^= seed;
+    multiply(a, b);
+    return mix(a ^ SECRET[0] ^ length, b ^ SECRET[1]);
+  }
+
+  /**
+   * @param data The bytes that are to be hashed.
+   * @param length The number of bytes.
+   * @param seed A seed that selects an independent hash function.
+   * @return A 64-bit unsigned integer that represents the hash of the data.
+   */
+  uint64_t operator()(const void *data, size_t length, uint64_t seed = 0) const {
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    seed = start(seed);
+    uint64_t a = 0, b = 0;
+    if (length <= 16) {
+      readShort(bytes, length, a, b);
+    } else {
+      size_t remaining = length;
+      if (remaining > 48) {
+        uint64_t lane1 = seed, lane2 = seed;
+        do {
+          seed = mix(read64(bytes) ^ SECRET[1], read64(bytes + 8) ^ seed);
+          lane1 = mix(read64(bytes + 16) ^ SECRET[2], read64(bytes + 24) ^ lane1);
+          lane2 = mix(read64(bytes + 32) ^ SECRET[3], read64(bytes + 40) ^ lane2);
+          bytes += 48;
+          remaining -= 48;
+        } while (remaining > 48);
+        seed ^= lane1 ^ lane2;
+      }
+      while (remaining > 16) {
+        seed = mix(read64(bytes) ^ SECRET[1], read64(bytes + 8) ^ seed);
+        bytes += 16;
+        remaining -= 16;
+      }
+      a = read64(bytes + remaining - 16);
+      b = read64(bytes + remaining - 8);
+    }
+    return finish(a, b, seed, length);
+  }
+
+  /**
+   * @param data The data, in string form, that is to be hashed.
+   * @return A 64-bit unsigned integer that represents the hash of the data.
+   */
+  uint64_t operator()(std::string_view data) const { return (*this)(data.data(), data.size()); }
+
+  /**
+   * @brief Computes the same hash as wyhash64 from data given in pieces, for example while it is being decoded.
+   * 
+   * Up to 48 bytes are held back until it is known whether more follow, since the last bytes of the input are read
+   * differently from the rest, along with the 16 bytes before them, which the last read may overlap.
+   */
+  class Stream {
+   public:
+    /**
+     * @brief Construct a new Stream object
+     * 
+     * @param seed A seed that selects an independent hash function, as for wyhash64.
+     */
+    explicit Stream(uint64_t seed = 0) : mSeed(start(seed)), mLane1(mSeed), mLane2(mSeed) {}
+
+    /**
+     * @brief Add the next piece of the data.
+     * 
+     * @param data The bytes that follow the ones added so far.
+     * @param length The number of bytes.
+     */
+    void update(const void *data, size_t length) {
+      const unsigned char *bytes = static_cast<const unsigned char *>(data);
+      this->mLength += length;
+      while (length > 0) {
+        // A full block followed by more data is not the end of the input, so it can be consumed.
+        if (this->mPending == BLOCK) this->consume();
+        size_t count = length < BLOCK - this->mPending ? length : BLOCK - this->mPending;
+        std::memcpy(this->mBuffer + HISTORY + this->mPending, bytes, count);
+        this->mPending += count;
+        bytes += count;
+        length -= count;
+      }
+    }
+
+    /**
+     * @brief Add the next piece of the data.
+     * 
+     * @param data The data, in string form, that follows the data added so far.
+     */
+    void update(std::string_view data) { this->update(data.data(), data.size()); }
+
+    /**
+     * @brief Get the hash of all the data added so far. More data may still be added afterwards.
+     * 
+     * @return The hash that wyhash64 returns for the concatenated data.
+     */
+    uint64_t finalize() const {
+      const unsigned char *bytes = this->mBuffer + HISTORY;
+      uint64_t seed = this->mSeed, a = 0, b = 0;
+      if (this->mLength <= 16) {
+        readShort(bytes, this->mPending, a, b);
+      } else {
+        size_t remaining = this->mPending;
+        if (this->mLength > 48) seed ^= this->mLane1 ^ this->mLane2;
+        while (remaining > 16) {
+          seed = mix(read64(bytes) ^ SECRET[1], read64(bytes + 8) ^ seed);
+          bytes += 16;
+          remaining -= 16;
+        }
+        a = read64(bytes + remaining - 16);
+        b = read64(bytes + remaining - 8);
+      }
+      return finish(a, b, seed, this->mLength);
+    }
+
+   private:
+    static constexpr size_t BLOCK = 48;    ///< The bytes consumed by one round over long inputs.
+    static constexpr size_t HISTORY = 16;  ///< The bytes kept from before the pending ones.
+
+    uint64_t mSeed, mLane1, mLane2;
+    size_t mLength = 0;   ///< The number of bytes added so far.
+    size_t mPending = 0;  ///< The number of bytes in the buffer after the history, not yet consumed.
+    unsigned char mBuffer[HISTORY + BLOCK] = {};
+
+    /**
+     * @brief Consume the full block of pending bytes and keep its last bytes as the history.
+     */
+    void consume() {
+      const unsigned char *block = this->mBuffer + HISTORY;
+      this->mSeed = mix(read64(block) ^ SECRET[1], read64(block + 8) ^ this->mSeed);
+      this->mLane1 = mix(read64(block + 16) ^ SECRET[2], read64(block + 24) ^ this->mLane1);
+      this->mLane2 = mix(read64(block + 32) ^ SECRET[3], read64(block + 40) ^ this->mLane2);
+      std::memcpy(this->mBuffer, this->mBuffer + BLOCK, HISTORY);
+      this->mPending = 0;
+    }
+  };
+};
+inline constexpr Wyhash64 wyhash64{};
+
+/**
+ * @brief A 128-bit hash, such as a fingerprint that stands in for a key that is not kept.
+ */
+struct Hash128 {
+  uint64_t low;
+  uint64_t high;
+
+  constexpr bool operator==(const Hash128 &other) const { return low == other.low && high == other.high; }
+  constexpr bool operator!=(const Hash128 &other) const { return !(*this == other); }
+  constexpr bool operator<(const Hash128 &other) const {
+    return high < other.high || (high == other.high && low < other.low);
+  }
+};
+
+/**
+ * @brief A 128-bit hash for fingerprints, made of two independent wyhash-style lanes.
  * 
- * @param data The data, in string form, that is to be hashed.
- * @return A 64-bit unsigned integer that represents the hash of the data. 
+ * Among n distinct keys, a 64-bit hash is expected to collide about n^2 / 2^65 times, which is already one collision
+ * at five billion keys, so a structure that keeps only the hashes of its keys cannot tell some of them apart. This hash
+ * runs a second chain of the same 128-bit multiplications over the same words, with its own seed, secrets and order
+ * of words, and keeps the state of the two chains apart until the end, so both halves of the hash have to collide at
+ * once. The low half is exactly wyhash64 of the data with the same seed. Each half mixes its own state, so this hash
+ * does twice the multiplications of wyhash64, but the two chains share their loads and run side by side.
+ */
+struct Wyhash128 {
+  static constexpr uint64_t SECRET[4] = {0xe7037ed1a0b428dbU, 0x8ebc6af09c88c6e3U, 0x589965cc75374cc3U,
+                                         0x1d8e4e27c47d124fU};
+
+  /**
+   * @param data The bytes that are to be hashed.
+   * @param length The number of bytes.
+   * @param seed A seed that selects an independent hash function.
+   * @return The 128-bit hash of the data.
+   */
+  Hash128 operator()(const void *data, size_t length, uint64_t seed = 0) const {
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    uint64_t low = Wyhash64::start(seed), high = low ^ SECRET[0];
+    uint64_t a = 0, b = 0;
+    if (length <= 16) {
+      Wyhash64::readShort(bytes, length, a, b);
+    } else {
+      size_t remaining = length;
+      if (remaining > 48) {
+        uint64_t low1 = low, low2 = low, high1 = high, high2 = high;
+        do {
+          uint64_t w0 = Wyhash64::read64(bytes), w1 = Wyhash64::read64(bytes + 8);
+          uint64_t w2 = Wyhash64::read64(bytes + 16), w3 = Wyhash64::read64(bytes + 24);
+          uint64_t w4 = Wyhash64::read64(bytes + 32), w5 = Wyhash64::read64(bytes + 40);
+          low = Wyhash64::mix(w0 ^ Wyhash64::SECRET[1], w1 ^ low);
+          low1 = Wyhash64::mix(w2 ^ Wyhash64::SECRET[2], w3 ^ low1);
+          low2 = Wyhash64::mix(w4 ^ Wyhash64::SECRET[3], w5 ^ low2);
+          high = Wyhash64::mix(w1 ^ SECRET[1], w0 ^ high);
+          high1 = Wyhash64::mix(w3 ^ SECRET[2], w2 ^ high1);
+          high2 = Wyhash64::mix(w5 ^ SECRET[3], w4 ^ high2);
+          bytes += 48;
+          remaining -= 48;
+        } while (remaining > 48);
+        low ^= low1 ^ low2;
+        high ^= high1 ^ high2;
+      }
+      while (remaining > 16) {
+        uint64_t w0 = Wyhash64::read64(bytes), w1 = Wyhash64::read64(bytes + 8);
+        low = Wyhash64::mix(w0 ^ Wyhash64::SECRET[1], w1 ^ low);
+        high = Wyhash64::mix(w1 ^ SECRET[1], w0 ^ high);
+        bytes += 16;
+        remaining -= 16;
+      }
+      a = Wyhash64::read64(bytes + remaining - 16);
+      b = Wyhash64::read64(bytes + remaining - 8);
+    }
+    return {Wyhash64::finish(a, b, low, length), Wyhash64::finish(b ^ SECRET[2], a ^ SECRET[3], high, length)};
+  }
+
+  /**
+   * @param data The data, in string form, that is to be hashed.
+   * @return The 128-bit hash of the data.
+   */
+  Hash128 operator()(std::string_view data) const { return (*this)(data.data(), data.size()); }
+};
+inline constexpr Wyhash128 wyhash128{};
+
+/**
+ * @brief Hash many keys with wyhash128 at once.
+ * 
+ * Hashing the tokens of a message this way costs one call instead of one per token, with wyhash128 inlined into the
+ * loop, and keys are hashed in pairs so that the dependent multiplications of one overlap those of the other. Every
+ * hash is exactly what wyhash128 returns for its key.
+ * 
+ * @param keys The keys that are to be hashed.
+ * @param count The number of keys.
+ * @param hashes Receives the hash of each key, in the same order. Must have room for count hashes.
+ */
+void batch128(const std::string_view *keys, size_t count, Hash128 *hashes);
+
+/**
+ * @brief A 64-bit hash built on CRC32C, which x86 CPUs with SSE4.2 and ARMv8 CPUs with the CRC extension compute in
+ * hardware, eight bytes per instruction.
+ * 
+ * The input is read as little-endian words that rotate between independent CRC32C streams, three for long inputs, so
+ * their latency chains overlap. The words after the last whole block go into two of the streams at once, so that short
+ * inputs are spread over 64 bits too. The streams are folded into two 32-bit CRCs, which are mixed together with the
+ * length by mix64, since a CRC on its own does not avalanche. On x86 the instruction is used only if CPUID reports SSE4.2 at
+ * run time, and otherwise, as on every other CPU, a table-driven CRC32C gives exactly the same hashes, so tables saved
+ * on one machine stay valid on another. Being linear, CRC32C is not suitable for keys chosen by an adversary.
+ */
+struct Crc32c64 {
+  /**
+   * @param data The bytes that are to be hashed.
+   * @param length The number of bytes.
+   * @param seed A seed that selects an independent hash function.
+   * @return A 64-bit unsigned integer that represents the hash of the data.
+   */
+  uint64_t operator()(const void *data, size_t length, uint64_t seed = 0) const;
+
+  /**
+   * @param data The data, in string form, that is to be hashed.
+   * @return A 64-bit unsigned integer that represents the hash of the data.
+   */
+  uint64_t operator()(std::string_view data) const { return (*this)(data.data(), data.size()); }
+
+  /**
+   * @brief Computes the same hash as crc32c_64 from data given in pieces, for example while it is being decoded.
+   */
+  class Stream {
+   public:
+    static constexpr size_t BLOCK = 24;  ///< The bytes consumed by one round of the CRCs.
+
+    /**
+     * @brief Construct a new Stream object
+     * 
+     * @param seed A seed that selects an independent hash function, as for crc32c_64.
+     */
+    explicit Stream(uint64_t seed = 0);
+
+    /**
+     * @brief Add the next piece of the data.
+     * 
+     * @param data The bytes that follow the ones added so far.
+     * @param length The number of bytes.
+     */
+    void update(const void *data, size_t length);
+
+    /**
+     * @brief Add the next piece of the data.
+     * 
+     * @param data The data, in string form, that follows the data added so far.
+     */
+    void update(std::string_view data) { this->update(data.data(), data.size()); }
+
+    /**
+     * @brief Get the hash of all the data added so far. More data may still be added afterwards.
+     * 
+     * @return The hash that crc32c_64 returns for the concatenated data.
+     */
+    uint64_t finalize() const;
+
+   private:
+    uint32_t mCrc[3];
+    size_t mLength;   ///< The number of bytes added so far.
+    size_t mPending;  ///< The number of bytes in the buffer, which never holds a whole block.
+    unsigned char mBuffer[BLOCK];
+
+    /**
+     * @brief Extend the CRCs by whole blocks of data.
+     * 
+     * @param bytes The data.
+     * @param blocks The number of blocks.
+     */
+    void consume(const unsigned char *bytes, size_t blocks);
+  };
+};
+inline constexpr Crc32c64 crc32c_64{};
+
+/**
+ * @brief Fold the case of a Unicode code point.
+ * 
+ * Applies the simple case folding of Unicode 14.0, the mappings of status C and S in CaseFolding.txt, under which every
+ * code point folds to exactly one code point: "K", "k" and the Kelvin sign all fold to "k", and "Σ", "σ" and "ς" all
+ * fold to "σ". Foldings that change the number of code points, such as "ß" to "ss", are not applied.
+ * 
+ * @param codePoint The code point to fold.
+ * @return The folded code point, which is the code point itself if it has no folding.
+ */
+uint32_t foldCodePoint(uint32_t codePoint);
+
+inline constexpr size_t FOLD_CHUNK = 64;  ///< The size of the buffer that foldChunk folds into.
+
+/**
+ * @brief Fold the case of the start of some UTF-8 data into a buffer.
+ * 
+ * Runs of ASCII are folded eight bytes at a time, with bit tricks on 64-bit words, and everything else one code point
+ * at a time with foldCodePoint. Bytes that are not part of valid UTF-8 are copied unchanged.
+ * 
+ * @param data The data that is to be folded.
+ * @param length The number of bytes.
+ * @param out Receives the folded bytes. Must have room for FOLD_CHUNK bytes.
+ * @param written Set to the number of bytes written to out.
+ * @param final Whether the data ends here. If not, a code point cut off at the end of the data is left unfolded, to be
+ *              folded together with the bytes that follow it.
+ * @return The number of bytes of data that were folded, which is less than length if out filled up or a code point was
+ *         cut off.
+ */
+size_t foldChunk(const char *data, size_t length, char *out, size_t &written, bool final = true);
+
+/**
+ * @brief Fold the case of UTF-8 data, as foldChunk does.
+ * 
+ * @param data The data that is to be folded.
+ * @return The folded data.
+ */
+std::string foldCase(std::string_view data);
+
+/**
+ * @brief Compare two strings ignoring case, without folding either into a copy.
+ * 
+ * @param a The first string.
+ * @param b The second string.
+ * @return true if foldCase would return the same for both strings.
+ * @return false otherwise.
+ */
+bool equalIgnoringCase(std::string_view a, std::string_view b);
+
+/**
+ * @brief A case-insensitive variant of a hash function, which hashes data as if it had been folded with foldCase.
+ * 
+ * The data is folded a chunk at a time into a buffer on the stack and fed to the hash function's Stream, so no folded
+ * copy of the data is ever allocated. Tables with one of the folded hash functions below also compare identifiers
+ * ignoring case, so that "FREE", "Free" and "free" share one entry.
+ * 
+ * @tparam Hash The hash function, which must have a Stream.
+ */
+template <typename Hash>
+struct Folded {
+  /**
+   * @param data The bytes that are to be hashed.
+   * @param length The number of bytes.
+   * @return The hash of the folded data.
+   */
+  uint64_t operator()(const void *data, size_t length) const {
+    const char *bytes = static_cast<const char *>(data);
+    typename Hash::Stream stream;
+    char buffer[FOLD_CHUNK];
+    while (length > 0) {
+      size_t written = 0;
+      size_t folded = foldChunk(bytes, length, buffer, written);
+      stream.update(buffer, written);
+      bytes += folded;
+      length -= folded;
+    }
+    return stream.finalize();
+  }
+
+  /**
+   * @param data The data, in string form, that is to be hashed.
+   * @return The hash of the folded data.
+   */
+  uint64_t operator()(std::string_view data) const { return (*this)(data.data(), data.size()); }
+
+  /**
+   * @brief Computes the same hash as Folded<Hash> from data given in pieces, which may cut code points in two.
+   */
+  class Stream {
+   public:
+    /**
+     * @brief Add the next piece of the data.
+     * 
+     * @param data The bytes that follow the ones added so far.
+     * @param length The number of bytes.
+     */
+    void update(const void *data, size_t length) {
+      if (length == 0) return;
+      const char *bytes = static_cast<const char *>(data);
+      char buffer[FOLD_CHUNK];
+      size_t written = 0;
+      if (this->mCutCount > 0) {
+        // Complete the code point cut off at the end of the last piece with the start of this one.
+        char joined[sizeof(this->mCut) + 1];
+        size_t taken = length < sizeof(joined) - this->mCutCount ? length : sizeof(joined) - this->mCutCount;
+        std::memcpy(joined, this->mCut, this->mCutCount);
+        std::memcpy(joined + this->mCutCount, bytes, taken);
+        size_t folded = foldChunk(joined, this->mCutCount + taken, buffer, written, false);
+        if (folded == 0) {
+          std::memcpy(this->mCut, joined, this->mCutCount + taken);
+          this->mCutCount += taken;
+          return;
+        }
+        this->mStream.update(buffer, written);
+        bytes += folded - this->mCutCount;
+        length -= folded - this->mCutCount;
+        this->mCutCount = 0;
+      }
+      while (length > 0) {
+        size_t folded = foldChunk(bytes, length, buffer, written, false);
+        if (folded == 0) break;
+        this->mStream.update(buffer, written);
+        bytes += folded;
+        length -= folded;
+      }
+      std::memcpy(this->mCut, bytes, length);
+      this->mCutCount = length;
+    }
+
+    /**
+     * @brief Add the next piece of the data.
+     * 
+     * @param data The data, in string form, that follows the data added so far.
+     */
+    void update(std::string_view data) { this->update(data.data(), data.size()); }
+
+    /**
+     * @brief Get the hash of all the data added so far. More data may still be added afterwards.
+     * 
+     * @return The hash that Folded<Hash> returns for the concatenated data.
+     */
+    uint64_t finalize() const {
+      typename Hash::Stream stream = this->mStream;
+      if (this->mCutCount > 0) {
+        char buffer[FOLD_CHUNK];
+        size_t written = 0;
+        foldChunk(this->mCut, this->mCutCount, buffer, written);
+        stream.update(buffer, written);
+      }
+      return stream.finalize();
+    }
+
+   private:
+    typename Hash::Stream mStream;
+    char mCut[3];  ///< The start of a code point cut off at the end of the last piece.
+    size_t mCutCount = 0;
+  };
+};
+inline constexpr Folded<Fnv1a64> fnv1a_64_folded{};
+inline constexpr Folded<Wyhash64> wyhash64_folded{};
+inline constexpr Folded<Crc32c64> crc32c_64_folded{};
+
+/**
+ * @brief Identifies the hash functions in this namespace, for files that must be read back with the same one.
+ */
+enum class Hasher : uint32_t {
+  UNKNOWN = 0,
+  FNV1A_64 = 1,
+  MOD10 = 2,
+  WYHASH_64 = 3,
+  CRC32C_64 = 4,
+  FNV1A_64_FOLDED = 5,
+  WYHASH_64_FOLDED = 6,
+  CRC32C_64_FOLDED = 7
+};
+
+/**
+ * @brief Find out which hash function of this namespace a std::function holds.
+ * 
+ * @tparam Function A std::function, or anything else with a target<T>() member.
+ * @param function The hashing function.
+ * @return The hash function, or Hasher::UNKNOWN for any other function, such as a lambda.
+ */
+template <typename Function>
+Hasher identify(const Function &function) {
+  if (function.template target<Fnv1a64>() != nullptr) return Hasher::FNV1A_64;
+  if (function.template target<Mod10>() != nullptr) return Hasher::MOD10;
+  if (function.template target<Wyhash64>() != nullptr) return Hasher::WYHASH_64;
+  if (function.template target<Crc32c64>() != nullptr) return Hasher::CRC32C_64;
+  if (function.template target<Folded<Fnv1a64>>() != nullptr) return Hasher::FNV1A_64_FOLDED;
+  if (function.template target<Folded<Wyhash64>>() != nullptr) return Hasher::WYHASH_64_FOLDED;
+  if (function.template target<Folded<Crc32c64>>() != nullptr) return Hasher::CRC32C_64_FOLDED;
+  return Hasher::UNKNOWN;
+}
+
+/**
+ * @brief Check whether a hash function ignores case, so that identifiers it hashes must be compared ignoring case too.
+ * 
+ * @param hasher The hash function.
+ * @return true for the folded hash functions.
+ * @return false for every other one.
+ */
+constexpr bool ignoresCase(Hasher hasher) {
+  return hasher == Hasher::FNV1A_64_FOLDED || hasher == Hasher::WYHASH_64_FOLDED || hasher == Hasher::CRC32C_64_FOLDED;
+}
+
+/**
+ * @brief Spread every bit of a 64-bit hash over all of its bits, using the finalizer of MurmurHash3.
+ * 
+ * Useful to derive well-distributed indices from a hash whose high bits are poorly mixed, as the high bits of FNV-1a
+ * are for short strings that only differ in their last few characters. The mapping is a bijection.
+ * 
+ * @param hash The hash to mix.
+ * @return The mixed hash.
+ */
+constexpr uint64_t mix64(uint64_t hash) {
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdU;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53U;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+/**
+ * @brief Hash every run of k consecutive bytes of some data, in one pass.
+ * 
+ * Uses a cyclic polynomial rolling hash, also known as buzhash: each byte maps to a random word, and the hash of a
+ * window is the xor of those words, each rotated by its distance from the end of the window. Moving the window by one
+ * byte then costs one rotation and two xors whatever k is, instead of hashing k bytes again. The hashes only depend on
+ * the bytes of a window, not on its position, so the same n-gram always hashes the same, as character n-gram features
+ * need. They are well spread for k below 64 and can be given to anything that takes a hash, such as
+ * CountMinSketch::addHash, but they differ from the other hash functions, so they must not be mixed with them.
+ * 
+ * @param data The data whose n-grams are to be hashed.
+ * @param k The number of bytes in each n-gram.
+ * @return The hash of the n-gram starting at each position, data.size() - k + 1 of them, or none if the data is shorter
+ *         than k or k is 0.
+ */
+std::vector<uint64_t> kgrams(std::string_view data, size_t k);
+
+/**
+ * @brief Hash every run of k consecutive tokens, given the hash of each token, in one pass.
+ * 
+ * Combines the token hashes with the same rolling scheme as kgrams, after spreading each with mix64, so that shingles of
+ * words can be counted like words themselves. Any hash function can hash the tokens, for example through batch.
+ * 
+ * @param tokens The hash of each token, in order.
+ * @param k The number of tokens in each shingle.
+ * @return The hash of the shingle starting at each token, tokens.size() - k + 1 of them, or none if there are fewer
+ *         than k tokens or k is 0.
+ */
+std::vector<uint64_t> shingles(const std::vector<uint64_t> &tokens, size_t k);
+
+/**
+ * @brief User-defined literals for hashing string constants at compile time.
+ */
+inline namespace literals {
+/**
+ * @brief Hash a string literal with hash::fnv1a_64, as in "Subject"_h.
+ * 
+ * @param data The characters of the literal.
+ * @param length The number of characters.
+ * @return The FNV-1a hash of the literal.
+ */
+constexpr uint64_t operator""_h(const char *data, size_t length) { return fnv1a_64(std::string_view(data, length)); }
+}  // namespace literals
+}  // namespace hash
+
+/**
+ * @brief Lets Hash128 fingerprints be kept in std::unordered_set and std::unordered_map. Their low half is already
+ * well mixed, so it is used as it is.
  */
-uint64_t mod10(std::string data);
-}  // namespace hash
\ No newline at end of file
+template <>
+struct std::hash<::hash::Hash128> {
+  size_t operator()(const ::hash::Hash128 &fingerprint) const { return static_cast<size_t>(fingerprint.low); }
+};
@@ -1,62 +1,187 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
+#include <cstdio>
+#include <fstream>
 #include <functional>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
 #include <optional>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <thread>
+#include <vector>
 
+#include "bloomfilter.hpp"
 #include "hash.hpp"
+#include "persistjob.hpp"
+#include "serialize.hpp"
+
+template <typename T>
+class HashEntry;
+
+/**
+ * @brief Destroys a hash entry and returns its memory to the resource it was allocated from.
+ * 
+ * The resource is recovered from the entry's identifier, so the deleter itself is stateless and an owning pointer to an
+ * entry is no bigger than a raw pointer.
+ * 
+ * @tparam T The data type that is stored in the entry.
+ */
+template <typename T>
+struct HashEntryDeleter {
+  void operator()(HashEntry<T> *entry) const {
+    std::pmr::memory_resource *resource = entry->getResource();
+    entry->~HashEntry<T>();
+    resource->deallocate(entry, sizeof(HashEntry<T>), alignof(HashEntry<T>));
+  }
+};
+
+/**
+ * @brief An owning pointer to a hash entry.
+ * 
+ * @tparam T The data type that is stored in the entry.
+ */
+template <typename T>
+using HashEntryPtr = std::unique_ptr<HashEntry<T>, HashEntryDeleter<T>>;
+
+/**
+ * @brief Allocate and construct a hash entry from a memory resource.
+ * 
+ * @tparam T The data type that is stored in the entry.
+ * @param resource The memory resource that the entry and its identifier are allocated from.
+ * @param args The arguments passed to the entry's constructor, not including the resource.
+ * @return An owning pointer to the new entry.
+ */
+template <typename T, typename... Args>
+HashEntryPtr<T> makeHashEntry(std::pmr::memory_resource *resource, Args &&...args) {
+  void *memory = resource->allocate(sizeof(HashEntry<T>), alignof(HashEntry<T>));
+  try {
+    return HashEntryPtr<T>(new (memory) HashEntry<T>(std::forward<Args>(args)..., resource));
+  } catch (...) {
+    resource->deallocate(memory, sizeof(HashEntry<T>), alignof(HashEntry<T>));
+    throw;
+  }
+}
 
 /**
  * @brief An entry to a hash table.
  * 
  * Implements a singly-linked list to handle hash collisions.
+ * The entry and its identifier are allocated from a std::pmr::memory_resource, which all entries of a list share.
  * 
  * @tparam T The data type that is stored in the entry.
  */
 template <typename T>
 class HashEntry {
  private:
-  std::string mIdentifier;
+  std::pmr::string mIdentifier;
   T mData;
+  uint64_t mHash;
 
  public:
-  std::unique_ptr<HashEntry<T>> mNext;  ///< The next entry in the linked list.
+  HashEntryPtr<T> mNext;  ///< The next entry in the linked list.
 
   /**
    * @brief Construct a new Hash Entry object.
    * 
+   * Entries should be created with makeHashEntry, which allocates them from the same resource.
+   * 
    * @param identifier The identifier used to look up the stored data.
    * @param data The data that is stored in this entry.
+   * @param hash The full hash of the identifier.
+   * @param resource The memory resource that the identifier is allocated from.
+   */
+  HashEntry(std::string_view identifier, T data, uint64_t hash, std::pmr::memory_resource *resource)
+      : mIdentifier(identifier, resource),
+        mData(data),
+        mHash(hash),
+        mNext(nullptr) {}
+
+  /**
+   * @brief Move an entry, and the rest of its list, to a new memory resource.
+   * 
+   * The identifier is only copied if the resource differs from the one it was allocated from.
+   * 
+   * @param other The entry to move from.
+   * @param resource The memory resource that the identifier is allocated from.
    */
-  HashEntry(std::string identifier, T data) : mIdentifier(identifier),
-                                              mData(data),
-                                              mNext(nullptr) {}
+  HashEntry(HashEntry<T> &&other, std::pmr::memory_resource *resource)
+      : mIdentifier(std::move(other.mIdentifier), resource),
+        mData(std::move(other.mData)),
+        mHash(other.mHash),
+        mNext(std::move(other.mNext)) {}
 
   /**
    * @brief Get the identifier of this entry.
    * 
    * @return The identifier of this entry.
    */
-  std::string getIdentifier() { return mIdentifier; }
+  const std::pmr::string &getIdentifier() const { return mIdentifier; }
+
+  /**
+   * @brief Get the memory resource this entry was allocated from.
+   * 
+   * @return The memory resource of this entry.
+   */
+  std::pmr::memory_resource *getResource() const { return mIdentifier.get_allocator().resource(); }
 
   /**
   * @brief Get the data stored in this entry.
   * 
   * @return The data stored in this entry.
   */
-  T get() { return mData; }
+  const T &get() const { return mData; }
+
+  /**
+  * @brief Get a mutable reference to the data stored in this entry.
+  * 
+  * @return The data stored in this entry.
+  */
+  T &get() { return mData; }
+
+  /**
+   * @brief Get the full hash of this entry's identifier.
+   * 
+   * Stored so that chains can be searched, and entries moved between tables, without hashing the identifier again.
+   * 
+   * @return The hash of this entry's identifier.
+   */
+  uint64_t getHash() const { return mHash; }
+
+  /**
+   * @brief Check whether this entry holds an identifier.
+   * 
+   * Compares the stored hash first, so most mismatches never touch the identifier string.
+   * 
+   * @param identifier The identifier to compare against.
+   * @param hash The full hash of the identifier.
+   * @param ignoreCase Whether identifiers that only differ in case are the same, as they are for a folded hash.
+   * @return true if this entry holds the identifier.
+   * @return false otherwise.
+   */
+  bool matches(std::string_view identifier, uint64_t hash, bool ignoreCase = false) const {
+    if (mHash != hash) return false;
+    std::string_view stored(mIdentifier);
+    return stored == identifier || (ignoreCase && hash::equalIgnoringCase(stored, identifier));
+  }
 
   /**
    * @brief Search this and all subsequent entries for an identifier.
    * 
    * @param identifier The identifier to search for.
+   * @param hash The full hash of the identifier.
+   * @param ignoreCase Whether identifiers that only differ in case are the same.
    * @return The data stored at the requested identifier, if it exists.
    */
-  std::optional<T> search(std::string identifier) {
-    if (this->mIdentifier == identifier) return this->get();
-    if (this->mNext != nullptr) return this->mNext->search(identifier);
+  std::optional<T> search(std::string identifier, uint64_t hash, bool ignoreCase = false) {
+    if (this->matches(identifier, hash, ignoreCase)) return this->get();
+    if (this->mNext != nullptr) return this->mNext->search(identifier, hash, ignoreCase);
     return std::nullopt;
   }
 
@@ -69,14 +194,16 @@ class HashEntry {
    * 
    * @param identifier The identifier of the data that is to be set.
    * @param data The data that is to be set.
+   * @param hash The full hash of the identifier.
+   * @param ignoreCase Whether identifiers that only differ in case are the same.
    */
-  void set(std::string identifier, T data) {
-    if (this->mIdentifier == identifier) {
+  void set(std::string identifier, T data, uint64_t hash, bool ignoreCase = false) {
+    if (this->matches(identifier, hash, ignoreCase)) {
       this->mData = data;
     } else if (this->mNext != nullptr)
-      this->mNext->set(identifier, data);
+      this->mNext->set(identifier, data, hash, ignoreCase);
     else
-      this->mNext = std::make_unique<HashEntry<T>>(identifier, data);
+      this->mNext = makeHashEntry<T>(this->getResource(), identifier, data, hash);
   }
 
   /**
@@ -86,16 +213,18 @@ class HashEntry {
    * 
    * @param identifier The identifier of the data that is to be added.
    * @param data The data that is to be added.
+   * @param hash The full hash of the identifier.
+   * @param ignoreCase Whether identifiers that only differ in case are the same.
    * @return true if the entry is successfully created.
    * @return false if an entry with the given identifier already exists.
    */
-  bool add(std::string identifier, T data) {
-    if (this->mIdentifier == identifier) return false;
+  bool add(std::string identifier, T data, uint64_t hash, bool ignoreCase = false) {
+    if (this->matches(identifier, hash, ignoreCase)) return false;
     if (this->mNext == nullptr) {
-      this->mNext = std::make_unique<HashEntry<T>>(identifier, data);
+      this->mNext = makeHashEntry<T>(this->getResource(), identifier, data, hash);
       return true;
     }
-    return this->mNext->add(identifier, data);
+    return this->mNext->add(identifier, data, hash, ignoreCase);
   }
 
   /**
@@ -105,39 +234,314 @@ class HashEntry {
    * Will NOT remove self, even if it has the correct identifier.
    * 
    * @param identifier The identifier of the data to be removed.
+   * @param hash The full hash of the identifier.
+   * @param ignoreCase Whether identifiers that only differ in case are the same.
    * @return true if the data was successfully deleted.
    * @return false if the identifier could not be found.
    */
-  bool remove(std::string identifier) {
+  bool remove(std::string identifier, uint64_t hash, bool ignoreCase = false) {
     if (this->mNext == nullptr) return false;
-    if (this->mNext->getIdentifier() == identifier) {
+    if (this->mNext->matches(identifier, hash, ignoreCase)) {
       std::unique_ptr tmp = std::move(this->mNext->mNext);
       this->mNext = std::move(tmp);
       return true;
     }
-    return this->mNext->remove(identifier);
+    return this->mNext->remove(identifier, hash, ignoreCase);
   }
 };
 
 /**
  * @brief An implementation of a hash table.
  * 
+ * All memory used by the table, including the bucket array, the entries and their identifiers, comes from a
+ * std::pmr::memory_resource. By default this is the global default resource, but a table can be backed by, for example,
+ * a std::pmr::monotonic_buffer_resource for short-lived tables or a std::pmr::unsynchronized_pool_resource per thread.
+ * The resource must outlive the table.
+ * 
+ * A table can optionally keep a BloomFilter of the hashes it holds, so that lookups for absent identifiers are usually
+ * rejected without touching the bucket array. The filter is updated as entries are added and rebuilt when the table is
+ * compacted, which also clears out the bits of removed entries.
+ * 
+ * A table that hashes with one of the folded hashes, such as hash::fnv1a_64_folded, is case-insensitive: "FREE" and
+ * "free" name the same entry. Lookups hash the identifier as it is, without making a lowercase copy, and compare
+ * identifiers ignoring case only once their full hashes are equal.
+ * 
  * @tparam buckets How mant buckets are to be used in the table.
  * @tparam T The type of data to be stored in the table.
  */
 template <uint64_t buckets, typename T>
 class HashTable {
  private:
-  std::function<uint64_t(std::string)> mHashFunc;
-  std::unique_ptr<HashEntry<T>> mTable[buckets];
+  static constexpr uint64_t FILE_MAGIC = 0x3230205442544848;  ///< Identifies files written by save.
+
+  std::function<uint64_t(std::string_view)> mHashFunc;
+  bool mIgnoreCase;  ///< Whether mHashFunc is a folded hash, so that identifiers are compared ignoring case.
+  std::pmr::memory_resource *mResource;
+  HashEntryPtr<T> *mTable;
+  std::optional<BloomFilter> mFilter;
+  uint64_t mVersion;  ///< Incremented whenever entries may have been destroyed or moved, which invalidates handles.
+
+  /**
+   * @brief Allocate an empty bucket array from a memory resource.
+   * 
+   * @param resource The memory resource to allocate from.
+   * @return The new bucket array.
+   */
+  static HashEntryPtr<T> *allocateTable(std::pmr::memory_resource *resource) {
+    HashEntryPtr<T> *table =
+        static_cast<HashEntryPtr<T> *>(resource->allocate(sizeof(HashEntryPtr<T>) * buckets, alignof(HashEntryPtr<T>)));
+    for (uint64_t i = 0; i < buckets; ++i) new (&table[i]) HashEntryPtr<T>(nullptr);
+    return table;
+  }
+
+  /**
+   * @brief Destroy every entry and return the bucket array to its memory resource.
+   */
+  void releaseTable() {
+    if (this->mTable == nullptr) return;
+    for (uint64_t i = 0; i < buckets; ++i) this->mTable[i].~HashEntryPtr<T>();
+    this->mResource->deallocate(this->mTable, sizeof(HashEntryPtr<T>) * buckets, alignof(HashEntryPtr<T>));
+    this->mTable = nullptr;
+  }
+
+  /**
+   * @brief Merge one bucket of another table into the same bucket of this table.
+   * 
+   * Both tables use the same number of buckets and the same hash function, so every entry of the source bucket belongs
+   * in the same bucket here, and its stored hash can be reused as is.
+   * 
+   * @tparam Combine A callable taking the existing data and the incoming data and returning the merged data.
+   * @param bucket The bucket to merge.
+   * @param source The first entry of the other table's bucket.
+   * @param combine Merges data for identifiers that exist in both tables.
+   * @param filter The filter to add the merged hashes to, or nullptr.
+   * @param allocation The lock that guards the table's memory resource, or nullptr if only this thread uses it.
+   */
+  template <typename Combine>
+  void mergeBucket(uint64_t bucket, const HashEntry<T> *source, Combine &combine, BloomFilter *filter,
+                   std::mutex *allocation = nullptr) {
+    for (; source != nullptr; source = source->mNext.get())
+      this->mergeEntry(bucket, *source, source->getHash(), combine, filter, allocation);
+  }
+
+  /**
+   * @brief Merge one entry of another table into a bucket of this table.
+   * 
+   * @tparam Combine A callable taking the existing data and the incoming data and returning the merged data.
+   * @param bucket The bucket that the entry belongs in.
+   * @param source The entry to merge.
+   * @param fullHash The full hash of the entry's identifier under this table's hash function.
+   * @param combine Merges data for identifiers that exist in both tables.
+   * @param filter The filter to add the merged hash to, or nullptr.
+   * @param allocation The lock that guards the table's memory resource, or nullptr if only this thread uses it.
+   */
+  template <typename Combine>
+  void mergeEntry(uint64_t bucket, const HashEntry<T> &source, uint64_t fullHash, Combine &combine,
+                  BloomFilter *filter, std::mutex *allocation = nullptr) {
+    if (filter != nullptr) filter->insert(fullHash);
+    HashEntryPtr<T> *link = &this->mTable[bucket];
+    while (*link != nullptr && !(*link)->matches(source.getIdentifier(), fullHash, this->mIgnoreCase))
+      link = &(*link)->mNext;
+    if (*link != nullptr) {
+      (*link)->get() = combine((*link)->get(), source.get());
+      return;
+    }
+    std::unique_lock<std::mutex> lock;
+    if (allocation != nullptr) lock = std::unique_lock<std::mutex>(*allocation);
+    *link = makeHashEntry<T>(this->mResource, source.getIdentifier(), source.get(), fullHash);
+  }
+
+  /**
+   * @brief Check whether another table is known to hash identifiers exactly as this one does.
+   * 
+   * Hash functions that hash::identify does not know, such as lambdas, are never assumed to be the same.
+   * 
+   * @param other The other table.
+   * @return true if the hashes stored in the other table are valid in this one.
+   */
+  bool sameHasher(const HashTable<buckets, T> &other) const {
+    hash::Hasher hasher = hash::identify(this->mHashFunc);
+    return hasher != hash::Hasher::UNKNOWN && hasher == hash::identify(other.mHashFunc);
+  }
+
+  /**
+   * @brief Replace the filter with a new one that holds exactly the hashes currently in the table.
+   * 
+   * @param capacity The number of entries the filter is sized for, raised to the number of entries in the table.
+   * @param bitsPerEntry The number of bits the filter spends per expected entry.
+   */
+  void rebuildFilter(uint64_t capacity, uint32_t bitsPerEntry) {
+    uint64_t count = 0;
+    for (uint64_t i = 0; i < buckets; ++i)
+      for (const HashEntry<T> *entry = this->mTable[i].get(); entry != nullptr; entry = entry->mNext.get()) ++count;
+
+    this->mFilter.reset();
+    this->mFilter.emplace(std::max(capacity, count), bitsPerEntry, this->mResource);
+    for (uint64_t i = 0; i < buckets; ++i)
+      for (const HashEntry<T> *entry = this->mTable[i].get(); entry != nullptr; entry = entry->mNext.get())
+        this->mFilter->insert(entry->getHash());
+  }
+
+  /**
+   * @brief Write the header and every entry of the table in the format of save.
+   * 
+   * @param out The stream to write to.
+   * @return true if everything was written.
+   * @return false if the stream failed.
+   */
+  bool writeContents(std::ostream &out) const {
+    uint64_t count = 0;
+    for (uint64_t i = 0; i < buckets; ++i)
+      for (const HashEntry<T> *entry = this->mTable[i].get(); entry != nullptr; entry = entry->mNext.get()) ++count;
+
+    bool ok = serialize::write(out, FILE_MAGIC) && serialize::write(out, buckets) &&
+              serialize::write(out, hash::identify(this->mHashFunc)) && serialize::write(out, count);
+    for (uint64_t i = 0; i < buckets && ok; ++i)
+      for (const HashEntry<T> *entry = this->mTable[i].get(); entry != nullptr && ok; entry = entry->mNext.get())
+        ok = serialize::write(out, entry->getHash()) && serialize::write(out, entry->getIdentifier()) &&
+             serialize::write(out, entry->get());
+    return ok;
+  }
 
  public:
+  /**
+   * @brief A direct reference to the data of one entry, which skips hashing and the chain walk on repeated access.
+   * 
+   * A handle stays valid until the next structural change of its table: a successful remove or removeIf, compact, load,
+   * or assigning to the table. Adding other entries with set or mergeFrom does not invalidate it, since entries never
+   * move once created. Use HashTable::isValid to check a handle that may have outlived such a change.
+   */
+  class Handle {
+   private:
+    friend class HashTable<buckets, T>;
+
+    HashEntry<T> *mEntry;
+    uint64_t mVersion;
+
+    Handle(HashEntry<T> *entry, uint64_t version) : mEntry(entry), mVersion(version) {}
+
+   public:
+    /**
+     * @brief Get the identifier of the entry.
+     * 
+     * @return The identifier of the entry.
+     */
+    const std::pmr::string &getIdentifier() const { return this->mEntry->getIdentifier(); }
+
+    /**
+     * @brief Get the data of the entry, which may be modified in place.
+     * 
+     * @return A reference to the data of the entry.
+     */
+    T &operator*() const { return this->mEntry->get(); }
+
+    /**
+     * @brief Access a member of the data of the entry.
+     * 
+     * @return A pointer to the data of the entry.
+     */
+    T *operator->() const { return &this->mEntry->get(); }
+  };
+
   /**
   * @brief Construct a new Hash Table<buckets,  T> object
   * 
   * @param hashFunc The hashing function to be used by this table.
+  * @param resource The memory resource that all of the table's memory is allocated from.
   */
-  HashTable<buckets, T>(std::function<uint64_t(std::string)> hashFunc = hash::fnv1a_64) : mHashFunc(hashFunc) {}
+  HashTable<buckets, T>(std::function<uint64_t(std::string_view)> hashFunc = hash::fnv1a_64,
+                        std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : mHashFunc(hashFunc),
+        mIgnoreCase(hash::ignoresCase(hash::identify(this->mHashFunc))),
+        mResource(resource),
+        mTable(allocateTable(resource)),
+        mVersion(0) {}
+
+  HashTable<buckets, T>(const HashTable<buckets, T> &) = delete;
+  HashTable<buckets, T> &operator=(const HashTable<buckets, T> &) = delete;
+
+  /**
+   * @brief Move a Hash Table<buckets, T> object
+   * 
+   * The moved-from table must not be used again, other than to be destroyed or assigned to.
+   * 
+   * @param other The table to move from.
+   */
+  HashTable<buckets, T>(HashTable<buckets, T> &&other) noexcept
+      : mHashFunc(std::move(other.mHashFunc)),
+        mIgnoreCase(other.mIgnoreCase),
+        mResource(other.mResource),
+        mTable(other.mTable),
+        mFilter(std::move(other.mFilter)),
+        mVersion(other.mVersion) {
+    other.mTable = nullptr;
+  }
+
+  /**
+   * @brief Move-assign a Hash Table<buckets, T> object
+   * 
+   * @param other The table to move from.
+   * @return This table.
+   */
+  HashTable<buckets, T> &operator=(HashTable<buckets, T> &&other) noexcept {
+    if (this != &other) {
+      this->releaseTable();
+      this->mHashFunc = std::move(other.mHashFunc);
+      this->mIgnoreCase = other.mIgnoreCase;
+      this->mResource = other.mResource;
+      this->mTable = other.mTable;
+      this->mFilter = std::move(other.mFilter);
+      // Handles into the entries this table held before must not pass as valid, whatever the other table's version was.
+      this->mVersion = std::max(this->mVersion, other.mVersion) + 1;
+      other.mTable = nullptr;
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Destroy the Hash Table<buckets, T> object, returning all of its memory to its resource.
+   */
+  ~HashTable<buckets, T>() { this->releaseTable(); }
+
+  /**
+   * @brief Get the memory resource that this table allocates from.
+   * 
+   * @return The memory resource of this table.
+   */
+  std::pmr::memory_resource *getResource() const { return this->mResource; }
+
+  /**
+   * @brief Check whether identifiers that only differ in case are treated as the same identifier.
+   * 
+   * This is the case when the table hashes with a folded hash such as hash::fnv1a_64_folded. An entry keeps the
+   * spelling of the identifier it was first set with.
+   * 
+   * @return true if the table's hashing function ignores case.
+   */
+  bool ignoresCase() const { return this->mIgnoreCase; }
+
+  /**
+   * @brief Start keeping a Bloom filter of the table's hashes, built from the entries already in the table.
+   * 
+   * Worthwhile when most lookups are for identifiers that are not in the table. The filter is allocated from the table's
+   * memory resource. Calling this again replaces the filter with one of the new size.
+   * 
+   * @param capacity The number of entries the filter is sized for. Compaction grows it to fit the table if needed.
+   * @param bitsPerEntry The number of bits the filter spends per expected entry.
+   */
+  void enableFilter(uint64_t capacity, uint32_t bitsPerEntry = 16) { this->rebuildFilter(capacity, bitsPerEntry); }
+
+  /**
+   * @brief Stop keeping a Bloom filter and free its memory.
+   */
+  void disableFilter() { this->mFilter.reset(); }
+
+  /**
+   * @brief Check whether the table keeps a Bloom filter.
+   * 
+   * @return true if lookups are checked against a filter first.
+   */
+  bool hasFilter() const { return this->mFilter.has_value(); }
 
   /**
    * @brief Get the data stored at a given identifier.
@@ -146,8 +550,10 @@ class HashTable {
    * @return The data stored at the given identifier, if it exists.
    */
   std::optional<T> get(std::string identifier) {
-    uint64_t hash = this->mHashFunc(identifier) % buckets;
-    return this->mTable[hash] != nullptr ? this->mTable[hash]->search(identifier) : std::nullopt;
+    uint64_t fullHash = this->mHashFunc(identifier);
+    if (this->mFilter.has_value() && !this->mFilter->mayContain(fullHash)) return std::nullopt;
+    uint64_t hash = fullHash % buckets;
+    return this->mTable[hash] != nullptr ? this->mTable[hash]->search(identifier, fullHash, this->mIgnoreCase) : std::nullopt;
   }
 
   /**
@@ -160,11 +566,13 @@ class HashTable {
    * @param data The data to be stored.
    */
   void set(std::string identifier, T data) {
-    uint64_t hash = this->mHashFunc(identifier) % buckets;
+    uint64_t fullHash = this->mHashFunc(identifier);
+    uint64_t hash = fullHash % buckets;
+    if (this->mFilter.has_value()) this->mFilter->insert(fullHash);
     if (this->mTable[hash] != nullptr)
-      this->mTable[hash]->set(identifier, data);
+      this->mTable[hash]->set(identifier, data, fullHash, this->mIgnoreCase);
     else
-      this->mTable[hash] = std::make_unique<HashEntry<T>>(identifier, data);
+      this->mTable[hash] = makeHashEntry<T>(this->mResource, identifier, data, fullHash);
   }
 
   /**
@@ -175,13 +583,281 @@ class HashTable {
    * @return false if the identifier does not exist in the table.
    */
   bool remove(std::string identifier) {
-    uint64_t hash = this->mHashFunc(identifier) % buckets;
+    uint64_t fullHash = this->mHashFunc(identifier);
+    if (this->mFilter.has_value() && !this->mFilter->mayContain(fullHash)) return false;
+    uint64_t hash = fullHash % buckets;
     if (this->mTable[hash] == nullptr) return false;
-    if (this->mTable[hash]->getIdentifier() == identifier) {
+    if (this->mTable[hash]->matches(identifier, fullHash, this->mIgnoreCase)) {
       std::unique_ptr tmp = std::move(this->mTable[hash]->mNext);
       this->mTable[hash] = std::move(tmp);
+      ++this->mVersion;
       return true;
     }
-    return this->mTable[hash]->remove(identifier);
+    if (!this->mTable[hash]->remove(identifier, fullHash, this->mIgnoreCase)) return false;
+    ++this->mVersion;
+    return true;
+  }
+
+  /**
+   * @brief Get a handle to the entry of an identifier, creating the entry if it does not exist yet.
+   * 
+   * Costs one hash and one chain walk, after which the data can be read and updated through the handle any number of
+   * times, for example to update several counters of the same token in a row.
+   * 
+   * @param identifier The identifier of the entry.
+   * @param data The data stored in the entry if it has to be created.
+   * @return A handle to the entry.
+   */
+  Handle findOrInsertHandle(std::string identifier, T data = T()) {
+    uint64_t fullHash = this->mHashFunc(identifier);
+    HashEntryPtr<T> *link = &this->mTable[fullHash % buckets];
+    while (*link != nullptr && !(*link)->matches(identifier, fullHash, this->mIgnoreCase)) link = &(*link)->mNext;
+    if (*link == nullptr) {
+      if (this->mFilter.has_value()) this->mFilter->insert(fullHash);
+      *link = makeHashEntry<T>(this->mResource, identifier, data, fullHash);
+    }
+    return Handle(link->get(), this->mVersion);
+  }
+
+  /**
+   * @brief Get a handle to the entry of an identifier, if it exists.
+   * 
+   * @param identifier The identifier of the entry.
+   * @return A handle to the entry, if it exists.
+   */
+  std::optional<Handle> findHandle(std::string identifier) {
+    uint64_t fullHash = this->mHashFunc(identifier);
+    if (this->mFilter.has_value() && !this->mFilter->mayContain(fullHash)) return std::nullopt;
+    HashEntry<T> *entry = this->mTable[fullHash % buckets].get();
+    while (entry != nullptr && !entry->matches(identifier, fullHash, this->mIgnoreCase)) entry = entry->mNext.get();
+    if (entry == nullptr) return std::nullopt;
+    return Handle(entry, this->mVersion);
+  }
+
+  /**
+   * @brief Check whether a handle from this table is still valid.
+   * 
+   * @param handle A handle returned by this table.
+   * @return true if no structural change has happened since the handle was returned.
+   * @return false if the handle must no longer be used.
+   */
+  bool isValid(const Handle &handle) const { return handle.mVersion == this->mVersion; }
+
+  /**
+   * @brief Merge the entries of another table into this table.
+   * 
+   * Entries that only exist in the other table are copied over.
+   * For identifiers that exist in both tables, the data is replaced with the result of combine.
+   * If both tables use the same hash function, the hashes stored in the other table are reused rather than recomputed.
+   * Otherwise every identifier of the other table is hashed again with this table's hash function, which also merges
+   * identifiers that only differ in case when this table ignores case.
+   * 
+   * @tparam Combine A callable taking the existing data and the incoming data and returning the merged data.
+   * @param other The table to merge into this one.
+   * @param combine Merges data for identifiers that exist in both tables.
+   */
+  template <typename Combine>
+  void mergeFrom(const HashTable<buckets, T> &other, Combine combine) {
+    BloomFilter *filter = this->mFilter.has_value() ? &*this->mFilter : nullptr;
+    if (this->sameHasher(other)) {
+      for (uint64_t i = 0; i < buckets; ++i) this->mergeBucket(i, other.mTable[i].get(), combine, filter);
+      return;
+    }
+    for (uint64_t i = 0; i < buckets; ++i) {
+      for (const HashEntry<T> *source = other.mTable[i].get(); source != nullptr; source = source->mNext.get()) {
+        uint64_t fullHash = this->mHashFunc(source->getIdentifier());
+        this->mergeEntry(fullHash % buckets, *source, fullHash, combine, filter);
+      }
+    }
+  }
+
+  /**
+   * @brief Merge the entries of several tables into this table in parallel.
+   * 
+   * The buckets are split into contiguous ranges, one per thread, and each thread merges its range of every table.
+   * Since no two threads ever touch the same bucket, the buckets need no locking. The memory resource is shared,
+   * though, and most resources, such as std::pmr::unsynchronized_pool_resource, may not be used from several threads
+   * at once, so new entries are allocated under a lock while lookups and combine run in parallel. The resource must
+   * not be used by other threads during the merge. The filter, if any, is not split by bucket, so it is rebuilt once
+   * the threads are done instead.
+   * Tables are merged in the order given, so the result is the same as calling mergeFrom on each table in turn. If any
+   * of them uses a different hash function from this table, their entries do not stay in the same bucket, so the tables
+   * are merged one after another on the calling thread instead.
+   * 
+   * @tparam Combine A callable taking the existing data and the incoming data and returning the merged data.
+   * @param others The tables to merge into this one.
+   * @param combine Merges data for identifiers that exist in more than one table. Must be safe to call from several threads.
+   * @param threads The number of threads to use.
+   */
+  template <typename Combine>
+  void mergeFrom(const std::vector<const HashTable<buckets, T> *> &others, Combine combine,
+                 unsigned threads = std::thread::hardware_concurrency()) {
+    for (const HashTable<buckets, T> *other : others) {
+      if (!this->sameHasher(*other)) {
+        for (const HashTable<buckets, T> *table : others) this->mergeFrom(*table, combine);
+        return;
+      }
+    }
+    uint64_t workers = std::max<uint64_t>(1, std::min<uint64_t>(threads, buckets));
+    std::mutex allocation;
+    auto mergeRange = [&](uint64_t begin, uint64_t end) {
+      Combine localCombine = combine;
+      for (uint64_t i = begin; i < end; ++i)
+        for (const HashTable<buckets, T> *other : others)
+          this->mergeBucket(i, other->mTable[i].get(), localCombine, nullptr, &allocation);
+    };
+
+    std::vector<std::thread> pool;
+    for (uint64_t w = 1; w < workers; ++w) pool.emplace_back(mergeRange, buckets * w / workers, buckets * (w + 1) / workers);
+    mergeRange(0, buckets / workers);
+    for (std::thread &thread : pool) thread.join();
+    if (this->mFilter.has_value()) this->rebuildFilter(this->mFilter->capacity(), this->mFilter->bitsPerEntry());
+  }
+
+  /**
+   * @brief Remove every entry that matches a predicate.
+   * 
+   * Sweeps each bucket once, unlinking matching entries in place, so no identifiers are rehashed.
+   * 
+   * @tparam Predicate A callable taking the identifier, as a std::string_view, and data of an entry and returning true if
+   *                   it should be removed.
+   * @param predicate The predicate that selects the entries to remove.
+   * @param compact Whether the table should be compacted after the sweep.
+   * @return The number of entries that were removed.
+   */
+  template <typename Predicate>
+  uint64_t removeIf(Predicate predicate, bool compact = false) {
+    uint64_t removed = 0;
+    for (uint64_t i = 0; i < buckets; ++i) {
+      HashEntryPtr<T> *link = &this->mTable[i];
+      while (*link != nullptr) {
+        if (predicate(std::string_view((*link)->getIdentifier()), (*link)->get())) {
+          HashEntryPtr<T> tmp = std::move((*link)->mNext);
+          *link = std::move(tmp);
+          ++removed;
+        } else {
+          link = &(*link)->mNext;
+        }
+      }
+    }
+    if (removed > 0) ++this->mVersion;
+    if (compact) this->compact();
+    return removed;
+  }
+
+  /**
+   * @brief Move every entry into freshly allocated storage.
+   * 
+   * After many removals, the surviving entries are scattered across memory that was allocated over the lifetime of the table.
+   * Compaction re-allocates the bucket array and then the entries, bucket by bucket and in chain order, and frees the old
+   * memory. Backing the compacted table with a fresh std::pmr::monotonic_buffer_resource lays all of it out contiguously.
+   * Identifiers and data are moved; identifiers are only copied when the memory resource changes.
+   * The filter, if any, is rebuilt from the surviving entries, dropping the bits left behind by removed ones.
+   * 
+   * @param resource The memory resource the table is moved to, which must outlive the table.
+   *                 If nullptr, the table's current resource is used.
+   */
+  void compact(std::pmr::memory_resource *resource = nullptr) {
+    if (resource == nullptr) resource = this->mResource;
+    HashEntryPtr<T> *table = allocateTable(resource);
+    for (uint64_t i = 0; i < buckets; ++i) {
+      HashEntryPtr<T> old = std::move(this->mTable[i]);
+      HashEntryPtr<T> *tail = &table[i];
+      while (old != nullptr) {
+        *tail = makeHashEntry<T>(resource, std::move(*old));
+        old = std::move((*tail)->mNext);
+        tail = &(*tail)->mNext;
+      }
+    }
+    this->releaseTable();
+    this->mResource = resource;
+    this->mTable = table;
+    ++this->mVersion;
+    if (this->mFilter.has_value()) this->rebuildFilter(this->mFilter->capacity(), this->mFilter->bitsPerEntry());
+  }
+
+  /**
+   * @brief Write every entry of the table to a file.
+   * 
+   * The file is written under a temporary name and renamed into place once complete, so an existing file at the path is
+   * never left half-written. Entries are stored with their hashes and data is written with serialize::write. The file
+   * also records which function of namespace hash the table hashes with, so that load can refuse a file whose hashes
+   * would not match its own.
+   * 
+   * @param path The path of the file.
+   * @return true if the file was written.
+   * @return false if the file could not be written.
+   */
+  bool save(const std::string &path) const {
+    std::string temporary = path + ".tmp";
+    {
+      std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+      bool ok = out.is_open() && this->writeContents(out);
+      out.close();
+      if (!ok || out.fail()) {
+        std::remove(temporary.c_str());
+        return false;
+      }
+    }
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+  }
+
+  /**
+   * @brief Replace the contents of the table with the entries in a file written by save.
+   * 
+   * The stored hashes are used as is, so the table must use the same hash function as the one that saved the file. That
+   * is checked when both tables hash with a function of namespace hash. Tables with any other hash function are trusted
+   * to match.
+   * 
+   * @param path The path of the file.
+   * @return true if the file was read.
+   * @return false if the file could not be read or was not saved by a table with the same number of buckets and hash
+   *         function. The table is then left unchanged.
+   */
+  bool load(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    uint64_t magic = 0, fileBuckets = 0, count = 0;
+    hash::Hasher hasher = hash::Hasher::UNKNOWN;
+    if (!serialize::read(in, magic) || magic != FILE_MAGIC) return false;
+    if (!serialize::read(in, fileBuckets) || fileBuckets != buckets) return false;
+    if (!serialize::read(in, hasher) || hasher != hash::identify(this->mHashFunc)) return false;
+    if (!serialize::read(in, count)) return false;
+
+    // Entries are read into a table of their own, which only replaces this table's buckets once all of them were read.
+    HashTable<buckets, T> loaded(this->mHashFunc, this->mResource);
+    std::pmr::string identifier(this->mResource);
+    for (uint64_t i = 0; i < count; ++i) {
+      uint64_t hash = 0;
+      T data{};
+      if (!serialize::read(in, hash) || !serialize::read(in, identifier) || !serialize::read(in, data)) return false;
+      HashEntryPtr<T> &bucket = loaded.mTable[hash % buckets];
+      if (bucket != nullptr)
+        bucket->set(std::string(identifier), data, hash, this->mIgnoreCase);
+      else
+        bucket = makeHashEntry<T>(this->mResource, identifier, data, hash);
+    }
+
+    std::swap(this->mTable, loaded.mTable);
+    ++this->mVersion;
+    if (this->mFilter.has_value()) this->rebuildFilter(this->mFilter->capacity(), this->mFilter->bitsPerEntry());
+    return true;
+  }
+
+  /**
+   * @brief Save the table to a file in the background.
+   * 
+   * Serializes the table into memory and forks a child that writes it to the file, much like Redis' BGSAVE, so the
+   * parent carries on as soon as the table is serialized instead of waiting for the disk. Serializing first costs a copy
+   * of the table's contents, but a forked child of a multithreaded process must not allocate or use streams, as another
+   * thread may have held their locks at the time of the fork.
+   * On platforms without fork, the file is written before this returns.
+   * 
+   * @param path The path of the file.
+   * @return A job that reports when, and whether, the file has been written.
+   */
+  PersistJob persistAsync(const std::string &path) const {
+    std::ostringstream out(std::ios::binary);
+    if (!this->writeContents(out)) return PersistJob::finished(false);
+    return PersistJob::write(path, out.str());
   }
 };
\ No newline at end of file
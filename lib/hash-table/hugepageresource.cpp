@@ -0,0 +1,95 @@
+#include "hugepageresource.hpp"
+
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define HUGE_PAGE_RESOURCE_MMAP
+#endif
+
+namespace {
+/**
+ * @brief Round a size up to a whole number of huge pages.
+ */
+size_t roundUp(size_t bytes) {
+  return (bytes + HugePageResource::HUGE_PAGE_SIZE - 1) / HugePageResource::HUGE_PAGE_SIZE *
+         HugePageResource::HUGE_PAGE_SIZE;
+}
+
+/**
+ * @brief Check whether an allocation is served by mmap rather than by the fallback resource.
+ */
+bool mapped(size_t bytes, size_t alignment) {
+#ifdef HUGE_PAGE_RESOURCE_MMAP
+  return bytes >= HugePageResource::HUGE_PAGE_SIZE && alignment <= HugePageResource::HUGE_PAGE_SIZE;
+#else
+  (void)bytes;
+  (void)alignment;
+  return false;
+#endif
+}
+}  // namespace
+
+HugePageResource::HugePageResource(std::pmr::memory_resource *fallback)
+    : mFallback(fallback), mTryHugetlb(true), mHugetlbBytes(0), mMadvisedBytes(0), mFallbackBytes(0) {}
+
+HugePageResource::Stats HugePageResource::stats() const {
+  return Stats{this->mHugetlbBytes.load(), this->mMadvisedBytes.load(), this->mFallbackBytes.load()};
+}
+
+void *HugePageResource::do_allocate(size_t bytes, size_t alignment) {
+  if (!mapped(bytes, alignment)) {
+    void *p = this->mFallback->allocate(bytes, alignment);
+    this->mFallbackBytes += bytes;
+    return p;
+  }
+
+#ifdef HUGE_PAGE_RESOURCE_MMAP
+  size_t length = roundUp(bytes);
+
+#ifdef MAP_HUGETLB
+  // Explicit huge pages only exist if the administrator reserved some, so stop asking once the pool runs dry.
+  if (this->mTryHugetlb.load(std::memory_order_relaxed)) {
+    void *p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+      this->mHugetlbBytes += length;
+      return p;
+    }
+    this->mTryHugetlb.store(false, std::memory_order_relaxed);
+  }
+#endif
+
+  // Over-allocate so the mapping can be trimmed to huge page alignment, which transparent huge pages require.
+  size_t padded = length + HUGE_PAGE_SIZE;
+  void *raw = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED) throw std::bad_alloc();
+  uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+  uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  if (aligned > start) munmap(raw, aligned - start);
+  if (aligned + length < start + padded)
+    munmap(reinterpret_cast<void *>(aligned + length), start + padded - aligned - length);
+
+  void *p = reinterpret_cast<void *>(aligned);
+#ifdef MADV_HUGEPAGE
+  madvise(p, length, MADV_HUGEPAGE);
+#endif
+  this->mMadvisedBytes += length;
+  return p;
+#else
+  throw std::bad_alloc();
+#endif
+}
+
+void HugePageResource::do_deallocate(void *p, size_t bytes, size_t alignment) {
+  if (!mapped(bytes, alignment)) {
+    this->mFallback->deallocate(p, bytes, alignment);
+    return;
+  }
+
+#ifdef HUGE_PAGE_RESOURCE_MMAP
+  size_t length = roundUp(bytes);
+  munmap(p, length);
+#endif
+}
+
+bool HugePageResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept { return this == &other; }
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+/**
+ * @brief A memory resource that backs large allocations with huge pages.
+ *
+ * Large tables that are accessed at random touch a different page on almost every lookup, which quickly exhausts the
+ * TLB when pages are only 4 KB. This resource maps every allocation of at least one huge page directly with mmap,
+ * first asking for explicit huge pages (MAP_HUGETLB) and, if none are reserved, falling back to ordinary pages that are
+ * aligned to the huge page size and marked with MADV_HUGEPAGE so transparent huge pages can back them. Smaller
+ * allocations, and every allocation on platforms without mmap, are forwarded to a fallback resource.
+ *
+ * To back a whole HashTable with huge pages, use this as the upstream of a std::pmr::monotonic_buffer_resource or
+ * std::pmr::unsynchronized_pool_resource whose chunks are at least HUGE_PAGE_SIZE, and build the table on that. The
+ * bucket array then comes straight from here, and the entries are carved out of huge-page chunks.
+ */
+class HugePageResource : public std::pmr::memory_resource {
+ public:
+  static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;  ///< The size of the huge pages that are requested.
+
+  /**
+   * @brief The total number of bytes allocated so far through each kind of backing.
+   */
+  struct Stats {
+    uint64_t hugetlb;    ///< Bytes backed by explicit huge pages.
+    uint64_t madvised;   ///< Bytes backed by ordinary pages marked for transparent huge pages.
+    uint64_t fallback;   ///< Bytes forwarded to the fallback resource.
+  };
+
+  /**
+   * @brief Construct a new Huge Page Resource object
+   *
+   * @param fallback The resource used for small allocations and where mmap is unavailable. Must outlive this resource.
+   */
+  explicit HugePageResource(std::pmr::memory_resource *fallback = std::pmr::new_delete_resource());
+
+  /**
+   * @brief Get the total number of bytes allocated so far through each kind of backing.
+   *
+   * Useful to check whether explicit huge pages were actually available.
+   *
+   * @return The allocation statistics.
+   */
+  Stats stats() const;
+
+ private:
+  std::pmr::memory_resource *mFallback;
+  std::atomic<bool> mTryHugetlb;
+  std::atomic<uint64_t> mHugetlbBytes;
+  std::atomic<uint64_t> mMadvisedBytes;
+  std::atomic<uint64_t> mFallbackBytes;
+
+  void *do_allocate(size_t bytes, size_t alignment) override;
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+};
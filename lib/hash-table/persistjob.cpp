@@ -0,0 +1,98 @@
+#include "persistjob.hpp"
+
+#include <cstdio>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#define PERSIST_JOB_FORK
+#endif
+
+namespace {
+const int RUNNING = -1;
+const int FAILED = 1;
+}  // namespace
+
+PersistJob::PersistJob(int pid) : mPid(pid), mStatus(pid < 0 ? FAILED : RUNNING) {}
+
+PersistJob PersistJob::finished(bool succeeded) {
+  PersistJob job(-1);
+  job.mStatus = succeeded ? 0 : FAILED;
+  return job;
+}
+
+PersistJob PersistJob::write(const std::string &path, const std::string &contents) {
+  std::string temporary = path + ".tmp";
+#ifdef PERSIST_JOB_FORK
+  pid_t pid = fork();
+  if (pid != 0) return PersistJob(pid);
+
+  // Nothing below may allocate or take a lock.
+  int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  bool ok = fd >= 0;
+  for (size_t written = 0; ok && written < contents.size();) {
+    ssize_t result = ::write(fd, contents.data() + written, contents.size() - written);
+    if (result < 0 && errno == EINTR) continue;
+    ok = result > 0;
+    if (ok) written += size_t(result);
+  }
+  if (fd >= 0 && close(fd) != 0) ok = false;
+  if (ok) ok = rename(temporary.c_str(), path.c_str()) == 0;
+  if (!ok && fd >= 0) unlink(temporary.c_str());
+  _exit(ok ? 0 : FAILED);
+#else
+  std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+  bool ok = out.is_open() && out.write(contents.data(), std::streamsize(contents.size())).good();
+  out.close();
+  if (!ok || out.fail()) {
+    std::remove(temporary.c_str());
+    return finished(false);
+  }
+  return finished(std::rename(temporary.c_str(), path.c_str()) == 0);
+#endif
+}
+
+PersistJob::PersistJob(PersistJob &&other) noexcept : mPid(other.mPid), mStatus(other.mStatus) {
+  other.mPid = -1;
+  other.mStatus = FAILED;
+}
+
+PersistJob &PersistJob::operator=(PersistJob &&other) noexcept {
+  if (this != &other) {
+    this->wait();
+    this->mPid = other.mPid;
+    this->mStatus = other.mStatus;
+    other.mPid = -1;
+    other.mStatus = FAILED;
+  }
+  return *this;
+}
+
+PersistJob::~PersistJob() { this->wait(); }
+
+bool PersistJob::done() {
+#ifdef PERSIST_JOB_FORK
+  if (this->mStatus != RUNNING) return true;
+  int status = 0;
+  int result = waitpid(this->mPid, &status, WNOHANG);
+  if (result == 0 || (result < 0 && errno == EINTR)) return false;
+  this->mStatus = result == this->mPid && WIFEXITED(status) ? WEXITSTATUS(status) : FAILED;
+#endif
+  return true;
+}
+
+bool PersistJob::wait() {
+#ifdef PERSIST_JOB_FORK
+  if (this->mStatus == RUNNING) {
+    int status = 0;
+    int result = waitpid(this->mPid, &status, 0);
+    while (result < 0 && errno == EINTR) result = waitpid(this->mPid, &status, 0);
+    this->mStatus = result == this->mPid && WIFEXITED(status) ? WEXITSTATUS(status) : FAILED;
+  }
+#endif
+  return this->mStatus == 0;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+
+/**
+ * @brief A background save of a table, running in a forked child process.
+ *
+ * The table is serialized before the fork and the child only writes the bytes out, so the parent can keep modifying
+ * its table while the file is written.
+ * The job must be waited on to learn whether the save succeeded. If it is destroyed first, it waits for the child so
+ * that no zombie process is left behind.
+ */
+class PersistJob {
+ private:
+  int mPid;
+  int mStatus;
+
+ public:
+  /**
+   * @brief Construct a job for a child process.
+   *
+   * @param pid The process id of the child, or -1 if the fork failed.
+   */
+  explicit PersistJob(int pid);
+
+  /**
+   * @brief Construct a job that has already finished, for when the save ran in the calling process.
+   *
+   * @param succeeded Whether the save succeeded.
+   */
+  static PersistJob finished(bool succeeded);
+
+  /**
+   * @brief Write a file in a forked child process.
+   *
+   * Another thread may hold a lock, such as the allocator's, at the time of the fork, and the child would then deadlock
+   * on it. The child therefore only makes async-signal-safe system calls. Like a table's save, it writes the file under
+   * a temporary name and renames it into place once complete. On platforms without fork, the file is written before
+   * this returns.
+   *
+   * @param path The path of the file.
+   * @param contents The bytes to write.
+   * @return A job that reports when, and whether, the file has been written.
+   */
+  static PersistJob write(const std::string &path, const std::string &contents);
+
+  PersistJob(const PersistJob &) = delete;
+  PersistJob &operator=(const PersistJob &) = delete;
+  PersistJob(PersistJob &&other) noexcept;
+  PersistJob &operator=(PersistJob &&other) noexcept;
+  ~PersistJob();
+
+  /**
+   * @brief Check, without blocking, whether the save has finished.
+   *
+   * @return true if the child has exited.
+   * @return false if it is still writing.
+   */
+  bool done();
+
+  /**
+   * @brief Block until the save has finished.
+   *
+   * @return true if the file was written successfully.
+   * @return false if the fork failed or the child could not write the file.
+   */
+  bool wait();
+};
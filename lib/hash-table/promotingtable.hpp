@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "countminsketch.hpp"
+#include "hash.hpp"
+#include "hashtable.hpp"
+
+/**
+ * @brief Counts identifiers approximately until they are frequent enough to be worth counting exactly.
+ *
+ * Every identifier is first counted in a CountMinSketch, which takes a fixed amount of memory however many distinct
+ * identifiers there are. Once its estimate reaches the threshold, the identifier is promoted into a HashTable with the
+ * estimate as its starting count, and from then on it is counted exactly in the table. Identifiers that only ever
+ * appear a handful of times, such as random strings, therefore never take up an entry.
+ *
+ * A promoted count can be slightly too high, by whatever the sketch overestimated at the time of promotion, but it is
+ * never too low. Since most identifiers are never promoted, most lookups in the table miss, so enabling the table's
+ * filter with table().enableFilter() is usually worthwhile.
+ *
+ * @tparam buckets How many buckets are to be used in the exact table.
+ * @tparam T The type of the exact counts.
+ */
+template <uint64_t buckets, typename T = int>
+class PromotingTable {
+ private:
+  CountMinSketch mSketch;
+  HashTable<buckets, T> mTable;
+  uint32_t mThreshold;
+
+ public:
+  /**
+   * @brief Construct a new Promoting Table<buckets, T> object
+   *
+   * @param threshold The estimated count at which an identifier is promoted into the exact table.
+   * @param sketchWidth The number of counters in each row of the sketch.
+   * @param sketchDepth The number of rows of the sketch.
+   * @param hashFunc The hashing function to be used by the sketch and the table.
+   * @param resource The memory resource that the exact table is allocated from.
+   */
+  PromotingTable<buckets, T>(uint32_t threshold, uint64_t sketchWidth, uint32_t sketchDepth = 4,
+                             std::function<uint64_t(std::string_view)> hashFunc = hash::fnv1a_64,
+                             std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : mSketch(sketchWidth, sketchDepth, hashFunc), mTable(hashFunc, resource), mThreshold(threshold) {}
+
+  /**
+   * @brief Count an identifier.
+   *
+   * @param identifier The identifier to count.
+   * @param count How many times to count it. Must not be negative.
+   * @return true if the identifier is counted exactly, because it was promoted now or earlier.
+   * @return false if it is still only counted in the sketch.
+   */
+  bool add(std::string identifier, T count = 1) {
+    std::optional<T> exact = this->mTable.get(identifier);
+    if (exact.has_value()) {
+      this->mTable.set(identifier, exact.value() + count);
+      return true;
+    }
+
+    uint32_t estimate = this->mSketch.add(identifier, static_cast<uint32_t>(count));
+    if (estimate < this->mThreshold) return false;
+    this->mTable.set(identifier, static_cast<T>(estimate));
+    return true;
+  }
+
+  /**
+   * @brief Get the exact count of a promoted identifier.
+   *
+   * @param identifier The identifier to look up.
+   * @return The count of the identifier, if it has been promoted.
+   */
+  std::optional<T> get(std::string identifier) { return this->mTable.get(identifier); }
+
+  /**
+   * @brief Get the best available count of an identifier, whether or not it has been promoted.
+   *
+   * @param identifier The identifier to look up.
+   * @return The exact count if the identifier has been promoted, and the sketch's estimate otherwise.
+   */
+  T estimate(std::string identifier) {
+    std::optional<T> exact = this->mTable.get(identifier);
+    return exact.has_value() ? exact.value() : static_cast<T>(this->mSketch.estimate(identifier));
+  }
+
+  /**
+   * @brief Get the estimated count at which identifiers are promoted.
+   *
+   * @return The promotion threshold.
+   */
+  uint32_t threshold() const { return this->mThreshold; }
+
+  /**
+   * @brief Get the table of promoted identifiers.
+   *
+   * @return The exact table.
+   */
+  HashTable<buckets, T> &table() { return this->mTable; }
+
+  /**
+   * @brief Get the sketch that identifiers are counted in before they are promoted.
+   *
+   * @return The sketch.
+   */
+  const CountMinSketch &sketch() const { return this->mSketch; }
+};
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "hash.hpp"
+
+/**
+ * @brief A fixed-capacity hash table that can be cleared in constant time.
+ *
+ * Intended for short-lived scratch data, such as the set of tokens already seen in the current message, that is
+ * thrown away and rebuilt over and over. Entries are stored in place using linear probing, and every slot is stamped
+ * with the generation in which it was written. A slot only counts as occupied if its stamp matches the table's current
+ * generation, so clear() simply starts a new generation. Slots are never freed, which lets their identifier strings
+ * keep their capacity from one use to the next.
+ *
+ * @tparam buckets How many slots are to be used in the table. This is also the maximum number of entries.
+ * @tparam T The type of data to be stored in the table.
+ */
+template <uint64_t buckets, typename T>
+class ScratchTable {
+ private:
+  /**
+   * @brief A single slot of the table.
+   */
+  struct Slot {
+    uint32_t generation = 0;
+    uint64_t hash = 0;
+    std::string identifier;
+    T data = T();
+  };
+
+  std::function<uint64_t(std::string_view)> mHashFunc;
+  std::unique_ptr<Slot[]> mSlots;
+  uint32_t mGeneration;
+  uint64_t mSize;
+
+  /**
+   * @brief Check whether a slot holds an entry from the current generation.
+   *
+   * @param index The index of the slot.
+   * @return true if the slot is occupied.
+   * @return false if the slot is empty or stale.
+   */
+  bool occupied(uint64_t index) const { return this->mSlots[index].generation == this->mGeneration; }
+
+  /**
+   * @brief Find the slot holding an identifier, or the empty slot where it would be inserted.
+   *
+   * @param identifier The identifier to search for.
+   * @param hash The hash of the identifier.
+   * @return The index of the matching or empty slot, or nullopt if the table is full and does not hold the identifier.
+   */
+  std::optional<uint64_t> probe(const std::string &identifier, uint64_t hash) const {
+    uint64_t index = hash % buckets;
+    for (uint64_t i = 0; i < buckets; ++i) {
+      if (!this->occupied(index)) return index;
+      const Slot &slot = this->mSlots[index];
+      if (slot.hash == hash && slot.identifier == identifier) return index;
+      index = index + 1 == buckets ? 0 : index + 1;
+    }
+    return std::nullopt;
+  }
+
+ public:
+  /**
+   * @brief Construct a new Scratch Table<buckets, T> object
+   *
+   * @param hashFunc The hashing function to be used by this table.
+   */
+  ScratchTable<buckets, T>(std::function<uint64_t(std::string_view)> hashFunc = hash::fnv1a_64)
+      : mHashFunc(hashFunc), mSlots(std::make_unique<Slot[]>(buckets)), mGeneration(1), mSize(0) {}
+
+  /**
+   * @brief Get the number of entries in the table.
+   *
+   * @return The number of entries in the current generation.
+   */
+  uint64_t size() const { return this->mSize; }
+
+  /**
+   * @brief Get the data stored at a given identifier.
+   *
+   * @param identifier The identifier of the requested data.
+   * @return The data stored at the given identifier, if it exists.
+   */
+  std::optional<T> get(std::string identifier) {
+    std::optional<uint64_t> index = this->probe(identifier, this->mHashFunc(identifier));
+    if (!index.has_value() || !this->occupied(*index)) return std::nullopt;
+    return this->mSlots[*index].data;
+  }
+
+  /**
+   * @brief Set the data stored at an identifier.
+   *
+   * Will create a new entry if one does not already exist.
+   * If an entry with the given identifier already exists, its data will be replaced.
+   *
+   * @param identifier The identifier of the data.
+   * @param data The data to be stored.
+   * @return true if the data was stored.
+   * @return false if the table is full.
+   */
+  bool set(std::string identifier, T data) {
+    uint64_t hash = this->mHashFunc(identifier);
+    std::optional<uint64_t> index = this->probe(identifier, hash);
+    if (!index.has_value()) return false;
+    Slot &slot = this->mSlots[*index];
+    if (!this->occupied(*index)) {
+      slot.generation = this->mGeneration;
+      slot.hash = hash;
+      slot.identifier.assign(identifier);
+      ++this->mSize;
+    }
+    slot.data = data;
+    return true;
+  }
+
+  /**
+   * @brief Add a new entry to the table.
+   *
+   * Useful for deduplication, since it reports whether the identifier was already present.
+   *
+   * @param identifier The identifier of the data that is to be added.
+   * @param data The data that is to be added.
+   * @return true if the entry is successfully created.
+   * @return false if an entry with the given identifier already exists, or if the table is full.
+   */
+  bool add(std::string identifier, T data) {
+    uint64_t hash = this->mHashFunc(identifier);
+    std::optional<uint64_t> index = this->probe(identifier, hash);
+    if (!index.has_value() || this->occupied(*index)) return false;
+    Slot &slot = this->mSlots[*index];
+    slot.generation = this->mGeneration;
+    slot.hash = hash;
+    slot.identifier.assign(identifier);
+    slot.data = data;
+    ++this->mSize;
+    return true;
+  }
+
+  /**
+   * @brief Remove an entry from the table.
+   *
+   * Later entries of the same probe run are shifted back to fill the gap, so no tombstones are left behind.
+   *
+   * @param identifier The identifier of the data to be removed.
+   * @return true if the entry was successfully removed.
+   * @return false if the identifier does not exist in the table.
+   */
+  bool remove(std::string identifier) {
+    std::optional<uint64_t> found = this->probe(identifier, this->mHashFunc(identifier));
+    if (!found.has_value() || !this->occupied(*found)) return false;
+
+    uint64_t hole = *found;
+    uint64_t next = hole;
+    for (uint64_t i = 1; i < buckets; ++i) {
+      next = next + 1 == buckets ? 0 : next + 1;
+      if (!this->occupied(next)) break;
+      uint64_t home = this->mSlots[next].hash % buckets;
+      bool movable = hole <= next ? (home <= hole || home > next) : (home <= hole && home > next);
+      if (movable) {
+        std::swap(this->mSlots[hole], this->mSlots[next]);
+        hole = next;
+      }
+    }
+    this->mSlots[hole].generation = 0;
+    --this->mSize;
+    return true;
+  }
+
+  /**
+   * @brief Remove every entry from the table.
+   *
+   * Runs in constant time by starting a new generation. Only when the generation counter wraps around, once every
+   * 2^32 calls, are the slots actually reset.
+   */
+  void clear() {
+    this->mSize = 0;
+    if (++this->mGeneration != 0) return;
+    for (uint64_t i = 0; i < buckets; ++i) this->mSlots[i].generation = 0;
+    this->mGeneration = 1;
+  }
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+/**
+ * @brief Binary serialization of the values stored in hash tables.
+ *
+ * Trivially copyable types are written as their raw bytes, and strings as a 64-bit length followed by their characters.
+ * Files are only meant to be read back on the same architecture that wrote them.
+ */
+namespace serialize {
+
+/**
+ * @brief Write a trivially copyable value.
+ *
+ * @tparam T The type of the value.
+ * @param out The stream to write to.
+ * @param value The value to write.
+ * @return true if the value was written.
+ * @return false if the stream failed.
+ */
+template <typename T>
+bool write(std::ostream &out, const T &value) {
+  static_assert(std::is_trivially_copyable_v<T>, "serialize::write needs a trivially copyable type or an overload");
+  out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+  return out.good();
+}
+
+/**
+ * @brief Read a trivially copyable value.
+ *
+ * @tparam T The type of the value.
+ * @param in The stream to read from.
+ * @param value The value to read into.
+ * @return true if the value was read.
+ * @return false if the stream failed or ended early.
+ */
+template <typename T>
+bool read(std::istream &in, T &value) {
+  static_assert(std::is_trivially_copyable_v<T>, "serialize::read needs a trivially copyable type or an overload");
+  in.read(reinterpret_cast<char *>(&value), sizeof(T));
+  return in.good();
+}
+
+/**
+ * @brief Write a string of any allocator.
+ *
+ * @param out The stream to write to.
+ * @param value The string to write.
+ * @return true if the string was written.
+ * @return false if the stream failed.
+ */
+template <typename Allocator>
+bool write(std::ostream &out, const std::basic_string<char, std::char_traits<char>, Allocator> &value) {
+  uint64_t length = value.size();
+  if (!write(out, length)) return false;
+  out.write(value.data(), length);
+  return out.good();
+}
+
+/**
+ * @brief Read a string of any allocator.
+ *
+ * @param in The stream to read from.
+ * @param value The string to read into.
+ * @return true if the string was read.
+ * @return false if the stream failed or ended early.
+ */
+template <typename Allocator>
+bool read(std::istream &in, std::basic_string<char, std::char_traits<char>, Allocator> &value) {
+  // The length comes from the file, so the string only grows a chunk at a time as its characters are actually read. A
+  // corrupt length then makes the read fail at the end of the file instead of allocating whatever it says.
+  const uint64_t CHUNK = 1 << 16;
+  uint64_t length = 0;
+  if (!read(in, length)) return false;
+  value.clear();
+  while (length > 0) {
+    uint64_t count = length < CHUNK ? length : CHUNK;
+    size_t position = value.size();
+    value.resize(position + count);
+    in.read(value.data() + position, std::streamsize(count));
+    if (!in.good()) return false;
+    length -= count;
+  }
+  return in.good();
+}
+}  // namespace serialize
@@ -0,0 +1,283 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+/**
+ * @brief Count the number of set bits in a 64-bit word.
+ *
+ * @param bits The word whose bits are to be counted.
+ * @return The number of bits that are set in the word.
+ */
+inline uint32_t popcount64(uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountll(bits);
+#else
+  bits = bits - ((bits >> 1) & 0x5555555555555555U);
+  bits = (bits & 0x3333333333333333U) + ((bits >> 2) & 0x3333333333333333U);
+  bits = (bits + (bits >> 4)) & 0x0f0f0f0f0f0f0f0fU;
+  return (bits * 0x0101010101010101U) >> 56;
+#endif
+}
+
+/**
+ * @brief A group of 64 sparse slots.
+ *
+ * A bitmap records which slots are occupied and only occupied slots are stored, packed in order, in a single
+ * allocation. The position of a slot in the packed storage is the number of occupied slots before it, which is found
+ * with a popcount. An empty group does not allocate at all.
+ *
+ * A group does not keep a pointer to the memory resource its storage comes from, which would grow every group header
+ * by half. Instead the resource is passed to every call that allocates or frees, and the group must be released with
+ * the same resource before it is destroyed.
+ *
+ * @tparam T The type of data stored in each slot.
+ */
+template <typename T>
+class SparseGroup {
+ private:
+  uint64_t mBitmap;
+  T *mItems;
+
+  /**
+   * @brief Get the position of a slot in the packed storage.
+   *
+   * @param slot The slot in the group.
+   * @return The number of occupied slots before the given slot.
+   */
+  uint32_t offset(uint32_t slot) const { return popcount64(this->mBitmap & ((uint64_t(1) << slot) - 1)); }
+
+  /**
+   * @brief Reallocate the packed storage, leaving a gap at or removing the item at a position.
+   *
+   * The gap is left default-constructed.
+   *
+   * @param resource The memory resource of the storage.
+   * @param count The number of items after reallocation.
+   * @param position The position of the gap to open or of the item to drop.
+   * @param grow Whether a gap is opened (true) or an item is dropped (false).
+   */
+  void repack(std::pmr::memory_resource *resource, uint32_t count, uint32_t position, bool grow) {
+    T *items = count > 0 ? static_cast<T *>(resource->allocate(count * sizeof(T), alignof(T))) : nullptr;
+    uint32_t skip = grow ? 1 : 0;
+    uint32_t drop = grow ? 0 : 1;
+    for (uint32_t i = 0; i < position; ++i) new (&items[i]) T(std::move(this->mItems[i]));
+    if (grow) new (&items[position]) T();
+    for (uint32_t i = position; i + skip < count; ++i) new (&items[i + skip]) T(std::move(this->mItems[i + drop]));
+    this->destroy(resource, this->count());
+    this->mItems = items;
+  }
+
+  /**
+   * @brief Destroy the items of the packed storage and return it to its memory resource.
+   *
+   * @param resource The memory resource of the storage.
+   * @param count The number of items in the storage.
+   */
+  void destroy(std::pmr::memory_resource *resource, uint32_t count) {
+    if (this->mItems == nullptr) return;
+    for (uint32_t i = 0; i < count; ++i) this->mItems[i].~T();
+    resource->deallocate(this->mItems, count * sizeof(T), alignof(T));
+    this->mItems = nullptr;
+  }
+
+ public:
+  static constexpr uint32_t SIZE = 64;  ///< The number of slots in a group.
+
+  /**
+   * @brief Construct a new, empty Sparse Group object.
+   */
+  SparseGroup() : mBitmap(0), mItems(nullptr) {}
+
+  SparseGroup(const SparseGroup &) = delete;
+  SparseGroup &operator=(const SparseGroup &) = delete;
+
+  /**
+   * @brief Empty every slot and free the packed storage.
+   *
+   * @param resource The memory resource that the storage was allocated from.
+   */
+  void release(std::pmr::memory_resource *resource) {
+    this->destroy(resource, this->count());
+    this->mBitmap = 0;
+  }
+
+  /**
+   * @brief Get the number of occupied slots in this group.
+   *
+   * @return The number of occupied slots.
+   */
+  uint32_t count() const { return popcount64(this->mBitmap); }
+
+  /**
+   * @brief Check whether a slot is occupied.
+   *
+   * @param slot The slot to check.
+   * @return true if the slot is occupied.
+   * @return false if the slot is empty.
+   */
+  bool test(uint32_t slot) const { return (this->mBitmap >> slot) & 1; }
+
+  /**
+   * @brief Get the item stored in a slot.
+   *
+   * @param slot The slot to look up.
+   * @return A pointer to the stored item, or nullptr if the slot is empty.
+   */
+  T *get(uint32_t slot) const { return this->test(slot) ? &this->mItems[this->offset(slot)] : nullptr; }
+
+  /**
+   * @brief Store an item in a slot.
+   *
+   * If the slot is already occupied, its item is replaced.
+   *
+   * @param resource The memory resource that the packed storage is allocated from.
+   * @param slot The slot to store the item in.
+   * @param item The item to store.
+   * @return A reference to the stored item.
+   */
+  T &set(std::pmr::memory_resource *resource, uint32_t slot, T item) {
+    uint32_t position = this->offset(slot);
+    if (!this->test(slot)) {
+      this->repack(resource, this->count() + 1, position, true);
+      this->mBitmap |= uint64_t(1) << slot;
+    }
+    this->mItems[position] = std::move(item);
+    return this->mItems[position];
+  }
+
+  /**
+   * @brief Empty a slot.
+   *
+   * Frees the packed storage entirely once the last slot is emptied.
+   *
+   * @param resource The memory resource that the packed storage is allocated from.
+   * @param slot The slot to empty.
+   * @return true if the slot was occupied.
+   * @return false if the slot was already empty.
+   */
+  bool erase(std::pmr::memory_resource *resource, uint32_t slot) {
+    if (!this->test(slot)) return false;
+    this->repack(resource, this->count() - 1, this->offset(slot), false);
+    this->mBitmap &= ~(uint64_t(1) << slot);
+    return true;
+  }
+
+  /**
+   * @brief Get the number of bytes allocated for the packed storage of this group.
+   *
+   * @return The number of bytes of packed storage that this group holds from its memory resource.
+   */
+  uint64_t allocatedBytes() const { return this->count() * sizeof(T); }
+};
+
+/**
+ * @brief A fixed-size array that only spends memory on occupied slots.
+ *
+ * Modeled after the sparsetable from Google's sparsehash. The array is split into groups of 64 slots, each of which
+ * holds a bitmap and a packed list of occupied slots. An empty slot costs a fraction of a bit plus its share of a
+ * group header, while lookups remain constant time. The groups and their packed storage are all allocated from a
+ * std::pmr::memory_resource, which must outlive the array.
+ *
+ * @tparam T The type of data stored in each slot.
+ * @tparam size The number of slots in the array.
+ */
+template <typename T, uint64_t size>
+class SparseArray {
+ private:
+  static constexpr uint64_t GROUPS = (size + SparseGroup<T>::SIZE - 1) / SparseGroup<T>::SIZE;
+
+  std::pmr::memory_resource *mResource;
+  SparseGroup<T> *mGroups;
+
+ public:
+  /**
+   * @brief Construct a new, empty Sparse Array object.
+   *
+   * @param resource The memory resource that the array is allocated from.
+   */
+  explicit SparseArray(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : mResource(resource),
+        mGroups(static_cast<SparseGroup<T> *>(resource->allocate(GROUPS * sizeof(SparseGroup<T>),
+                                                                 alignof(SparseGroup<T>)))) {
+    for (uint64_t i = 0; i < GROUPS; ++i) new (&this->mGroups[i]) SparseGroup<T>();
+  }
+
+  SparseArray(const SparseArray &) = delete;
+  SparseArray &operator=(const SparseArray &) = delete;
+
+  /**
+   * @brief Destroy the Sparse Array object, returning all of its memory to its resource.
+   */
+  ~SparseArray() {
+    for (uint64_t i = 0; i < GROUPS; ++i) {
+      this->mGroups[i].release(this->mResource);
+      this->mGroups[i].~SparseGroup<T>();
+    }
+    this->mResource->deallocate(this->mGroups, GROUPS * sizeof(SparseGroup<T>), alignof(SparseGroup<T>));
+  }
+
+  /**
+   * @brief Get the memory resource that this array allocates from.
+   *
+   * @return The memory resource of this array.
+   */
+  std::pmr::memory_resource *getResource() const { return this->mResource; }
+
+  /**
+   * @brief Get the item stored at an index.
+   *
+   * @param index The index to look up.
+   * @return A pointer to the stored item, or nullptr if the index is empty.
+   */
+  T *get(uint64_t index) const {
+    return this->mGroups[index / SparseGroup<T>::SIZE].get(index % SparseGroup<T>::SIZE);
+  }
+
+  /**
+   * @brief Store an item at an index, replacing any existing item.
+   *
+   * @param index The index to store the item at.
+   * @param item The item to store.
+   * @return A reference to the stored item.
+   */
+  T &set(uint64_t index, T item) {
+    return this->mGroups[index / SparseGroup<T>::SIZE].set(this->mResource, index % SparseGroup<T>::SIZE,
+                                                           std::move(item));
+  }
+
+  /**
+   * @brief Empty the slot at an index.
+   *
+   * @param index The index to empty.
+   * @return true if the slot was occupied.
+   * @return false if the slot was already empty.
+   */
+  bool erase(uint64_t index) {
+    return this->mGroups[index / SparseGroup<T>::SIZE].erase(this->mResource, index % SparseGroup<T>::SIZE);
+  }
+
+  /**
+   * @brief Get the number of occupied slots.
+   *
+   * @return The number of occupied slots in the array.
+   */
+  uint64_t count() const {
+    uint64_t total = 0;
+    for (uint64_t i = 0; i < GROUPS; ++i) total += this->mGroups[i].count();
+    return total;
+  }
+
+  /**
+   * @brief Get the number of bytes used by the array, including group headers.
+   *
+   * @return The total number of bytes used by the array.
+   */
+  uint64_t memoryUsage() const {
+    uint64_t total = GROUPS * sizeof(SparseGroup<T>);
+    for (uint64_t i = 0; i < GROUPS; ++i) total += this->mGroups[i].allocatedBytes();
+    return total;
+  }
+};
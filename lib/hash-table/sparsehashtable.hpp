@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "hash.hpp"
+#include "hashtable.hpp"
+#include "sparsearray.hpp"
+
+/**
+ * @brief A hash table whose buckets are stored in a sparse array.
+ *
+ * Behaves exactly like HashTable, but empty buckets cost almost no memory.
+ * This makes it cheap to over-provision the number of buckets so that chains stay short, even when many tables are
+ * kept around at once and most of them are nearly empty.
+ *
+ * @tparam buckets How many buckets are to be used in the table.
+ * @tparam T The type of data to be stored in the table.
+ */
+template <uint64_t buckets, typename T>
+class SparseHashTable {
+ private:
+  std::function<uint64_t(std::string_view)> mHashFunc;
+  std::pmr::memory_resource *mResource;
+  SparseArray<HashEntryPtr<T>, buckets> mTable;
+
+ public:
+  /**
+   * @brief Construct a new Sparse Hash Table<buckets, T> object
+   *
+   * @param hashFunc The hashing function to be used by this table.
+   * @param resource The memory resource that the table's entries and buckets are allocated from.
+   */
+  SparseHashTable<buckets, T>(std::function<uint64_t(std::string_view)> hashFunc = hash::fnv1a_64,
+                              std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : mHashFunc(hashFunc), mResource(resource), mTable(resource) {}
+
+  /**
+   * @brief Get the data stored at a given identifier.
+   *
+   * @param identifier The identifier of the requested data.
+   * @return The data stored at the given identifier, if it exists.
+   */
+  std::optional<T> get(std::string identifier) {
+    uint64_t fullHash = this->mHashFunc(identifier);
+    HashEntryPtr<T> *bucket = this->mTable.get(fullHash % buckets);
+    return bucket != nullptr ? (*bucket)->search(identifier, fullHash) : std::nullopt;
+  }
+
+  /**
+   * @brief Set the data stored at an identifier.
+   *
+   * Will create a new table entry if one does not already exist.
+   * If an entry with the given identifier already exists, its data will be replaced.
+   *
+   * @param identifier The identifier of the data.
+   * @param data The data to be stored.
+   */
+  void set(std::string identifier, T data) {
+    uint64_t fullHash = this->mHashFunc(identifier);
+    uint64_t hash = fullHash % buckets;
+    HashEntryPtr<T> *bucket = this->mTable.get(hash);
+    if (bucket != nullptr)
+      (*bucket)->set(identifier, data, fullHash);
+    else
+      this->mTable.set(hash, makeHashEntry<T>(this->mResource, identifier, data, fullHash));
+  }
+
+  /**
+   * @brief Remove an entry from the table.
+   *
+   * Releases the bucket's storage if the removed entry was the last one in it.
+   *
+   * @param identifier The identifier of the data to be removed.
+   * @return true if the entry was successfully removed.
+   * @return false if the identifier does not exist in the table.
+   */
+  bool remove(std::string identifier) {
+    uint64_t fullHash = this->mHashFunc(identifier);
+    uint64_t hash = fullHash % buckets;
+    HashEntryPtr<T> *bucket = this->mTable.get(hash);
+    if (bucket == nullptr) return false;
+    if ((*bucket)->matches(identifier, fullHash)) {
+      if ((*bucket)->mNext == nullptr) return this->mTable.erase(hash);
+      std::unique_ptr tmp = std::move((*bucket)->mNext);
+      *bucket = std::move(tmp);
+      return true;
+    }
+    return (*bucket)->remove(identifier, fullHash);
+  }
+
+  /**
+   * @brief Get the number of bytes used by the bucket array.
+   *
+   * Does not include the entries themselves, which cost the same as in HashTable.
+   *
+   * @return The number of bytes used by the bucket array.
+   */
+  uint64_t bucketMemoryUsage() const { return this->mTable.memoryUsage(); }
+};
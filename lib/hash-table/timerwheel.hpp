@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief A hierarchical timer wheel.
+ *
+ * Time is measured in ticks. The wheel has four levels of 64 slots each. A slot on the first level holds the timers due
+ * on one tick, a slot on the second level those due within a block of 64 ticks, and so on, so the wheel covers 2^24
+ * ticks ahead before timers have to be parked in its last slot. Scheduling a timer is constant time. As the wheel
+ * advances, the timers of a higher-level slot are redistributed to the lower levels once their block is reached, and
+ * timers whose tick has passed are moved to a queue of due timers that the owner drains at its own pace.
+ *
+ * @tparam Item The data carried by each timer.
+ */
+template <typename Item>
+class TimerWheel {
+ private:
+  static constexpr uint32_t LEVELS = 4;
+  static constexpr uint32_t SLOT_BITS = 6;
+  static constexpr uint64_t SLOTS = uint64_t(1) << SLOT_BITS;
+
+  /**
+   * @brief A scheduled timer.
+   */
+  struct Timer {
+    uint64_t tick;
+    Item item;
+  };
+
+  std::vector<Timer> mSlots[LEVELS][SLOTS];
+  std::deque<Item> mDue;
+  uint64_t mCurrent;
+  uint64_t mScheduled;
+
+  /**
+   * @brief Put a timer in the slot that matches how far in the future it is due.
+   *
+   * @param timer The timer to place.
+   */
+  void place(Timer timer) {
+    if (timer.tick <= this->mCurrent) {
+      this->mDue.push_back(std::move(timer.item));
+      return;
+    }
+    ++this->mScheduled;
+    for (uint32_t level = 0; level < LEVELS; ++level) {
+      uint64_t shift = level * SLOT_BITS;
+      if ((timer.tick >> shift) - (this->mCurrent >> shift) < SLOTS) {
+        this->mSlots[level][(timer.tick >> shift) & (SLOTS - 1)].push_back(std::move(timer));
+        return;
+      }
+    }
+    // Beyond the range of the wheel: park it in the last slot of the top level, which is redistributed last.
+    uint64_t shift = (LEVELS - 1) * SLOT_BITS;
+    this->mSlots[LEVELS - 1][((this->mCurrent >> shift) + SLOTS - 1) & (SLOTS - 1)].push_back(std::move(timer));
+  }
+
+  /**
+   * @brief Take every timer out of a slot and place it again relative to the current tick.
+   *
+   * @param level The level of the slot.
+   * @param slot The index of the slot.
+   */
+  void redistribute(uint32_t level, uint64_t slot) {
+    std::vector<Timer> timers;
+    timers.swap(this->mSlots[level][slot]);
+    this->mScheduled -= timers.size();
+    for (Timer &timer : timers) this->place(std::move(timer));
+  }
+
+ public:
+  /**
+   * @brief Construct a new Timer Wheel object
+   *
+   * @param now The current tick.
+   */
+  explicit TimerWheel(uint64_t now = 0) : mCurrent(now), mScheduled(0) {}
+
+  /**
+   * @brief Get the tick the wheel has advanced to.
+   *
+   * @return The current tick.
+   */
+  uint64_t current() const { return this->mCurrent; }
+
+  /**
+   * @brief Get the number of timers that are scheduled or due but not yet taken.
+   *
+   * @return The number of pending timers.
+   */
+  uint64_t size() const { return this->mScheduled + this->mDue.size(); }
+
+  /**
+   * @brief Schedule a timer.
+   *
+   * @param tick The tick at which the timer is due. Timers for the current tick or earlier are due immediately.
+   * @param item The data carried by the timer.
+   */
+  void schedule(uint64_t tick, Item item) { this->place(Timer{tick, std::move(item)}); }
+
+  /**
+   * @brief Advance the wheel towards a tick, moving timers that become due to the due queue.
+   *
+   * @param now The tick to advance to.
+   * @param maxTicks The maximum number of ticks to step through, which bounds the work done by this call.
+   * @return true if the wheel reached the requested tick.
+   * @return false if it stopped early because of maxTicks.
+   */
+  bool advance(uint64_t now, uint64_t maxTicks) {
+    for (uint64_t steps = 0; this->mCurrent < now; ++steps) {
+      if (this->mScheduled == 0) {
+        this->mCurrent = now;
+        break;
+      }
+      if (steps == maxTicks) return false;
+
+      ++this->mCurrent;
+      for (uint32_t level = LEVELS - 1; level > 0; --level) {
+        uint64_t shift = level * SLOT_BITS;
+        if ((this->mCurrent & ((uint64_t(1) << shift) - 1)) == 0)
+          this->redistribute(level, (this->mCurrent >> shift) & (SLOTS - 1));
+      }
+      this->redistribute(0, this->mCurrent & (SLOTS - 1));
+    }
+    return true;
+  }
+
+  /**
+   * @brief Take the next due timer.
+   *
+   * @return The data of the timer, or nullopt if no timer is due.
+   */
+  std::optional<Item> popDue() {
+    if (this->mDue.empty()) return std::nullopt;
+    Item item = std::move(this->mDue.front());
+    this->mDue.pop_front();
+    return item;
+  }
+};
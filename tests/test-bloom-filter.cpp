@@ -0,0 +1,89 @@
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "bloomfilter.hpp"
+#include "catch.hpp"
+#include "hash.hpp"
+#include "hashtable.hpp"
+
+TEST_CASE("Bloom filter") {
+  BloomFilter filter(10000);
+
+  SECTION("Added hashes are always found") {
+    for (uint64_t i = 0; i < 10000; ++i) filter.insert(hash::fnv1a_64("token" + std::to_string(i)));
+    for (uint64_t i = 0; i < 10000; ++i) REQUIRE(filter.mayContain(hash::fnv1a_64("token" + std::to_string(i))));
+  }
+
+  SECTION("Few absent hashes are reported as present") {
+    for (uint64_t i = 0; i < 10000; ++i) filter.insert(hash::fnv1a_64("token" + std::to_string(i)));
+    uint64_t falsePositives = 0;
+    for (uint64_t i = 0; i < 100000; ++i) falsePositives += filter.mayContain(hash::fnv1a_64("absent" + std::to_string(i)));
+    REQUIRE(falsePositives < 1000);
+  }
+
+  SECTION("Filters can be cleared") {
+    filter.insert(hash::fnv1a_64("token"));
+    filter.clear();
+    REQUIRE(filter.mayContain(hash::fnv1a_64("token")) == false);
+  }
+
+  SECTION("Filters are sized by bits per entry") {
+    REQUIRE(filter.memoryUsage() == 10000 * 16 / 8);
+    REQUIRE(BloomFilter(1).memoryUsage() == BloomFilter::BLOCK_BYTES);
+  }
+}
+
+TEST_CASE("Hash table Bloom filter") {
+  HashTable<0xff, int> table;
+  table.set("existing", 1);
+  table.enableFilter(1000);
+  REQUIRE(table.hasFilter());
+
+  SECTION("Entries are found through the filter") {
+    REQUIRE(table.get("existing").value_or(-1) == 1);
+    table.set("new", 2);
+    REQUIRE(table.get("new").value_or(-1) == 2);
+    REQUIRE(table.get("absent").value_or(-1) == -1);
+    REQUIRE(table.remove("absent") == false);
+    REQUIRE(table.remove("new") == true);
+    REQUIRE(table.get("new").value_or(-1) == -1);
+  }
+
+  SECTION("Compaction rebuilds the filter") {
+    for (int i = 0; i < 2000; ++i) table.set("token" + std::to_string(i), i);
+    table.removeIf([](std::string_view, const int &data) { return data % 2 == 0; }, true);
+    REQUIRE(table.hasFilter());
+    for (int i = 0; i < 2000; ++i) REQUIRE(table.get("token" + std::to_string(i)).value_or(-1) == (i % 2 ? i : -1));
+    REQUIRE(table.get("existing").value_or(-1) == 1);
+  }
+
+  SECTION("Merged entries are added to the filter") {
+    HashTable<0xff, int> first, second;
+    first.set("first", 1);
+    second.set("second", 2);
+    table.mergeFrom(first, [](int a, int b) { return a + b; });
+    table.mergeFrom({&second}, [](int a, int b) { return a + b; }, 2);
+    REQUIRE(table.get("first").value_or(-1) == 1);
+    REQUIRE(table.get("second").value_or(-1) == 2);
+    REQUIRE(table.get("existing").value_or(-1) == 1);
+  }
+
+  SECTION("Loaded entries are added to the filter") {
+    HashTable<0xff, int> saved;
+    saved.set("saved", 3);
+    REQUIRE(saved.save("test-bloom-filter.bin"));
+    REQUIRE(table.load("test-bloom-filter.bin"));
+    REQUIRE(table.get("saved").value_or(-1) == 3);
+    REQUIRE(table.get("existing").value_or(-1) == -1);
+    std::remove("test-bloom-filter.bin");
+  }
+
+  SECTION("Filters can be disabled") {
+    table.disableFilter();
+    REQUIRE(table.hasFilter() == false);
+    REQUIRE(table.get("existing").value_or(-1) == 1);
+  }
+}
@@ -0,0 +1,107 @@
+#include <optional>
+#include <string>
+
+#include "catch.hpp"
+#include "clockcache.hpp"
+
+TEST_CASE("Clock cache") {
+  ClockCache<4, int> cache;
+
+  SECTION("Entries can be set, overwritten and deleted") {
+    REQUIRE(cache.get("a").value_or(-1) == -1);
+    cache.set("a", 1);
+    cache.set("b", 2);
+    REQUIRE(cache.get("a").value_or(-1) == 1);
+    cache.set("a", 3);
+    REQUIRE(cache.get("a").value_or(-1) == 3);
+    REQUIRE(cache.remove("a") == true);
+    REQUIRE(cache.remove("a") == false);
+    REQUIRE(cache.get("a").value_or(-1) == -1);
+    REQUIRE(cache.get("b").value_or(-1) == 2);
+    REQUIRE(cache.size() == 1);
+  }
+
+  SECTION("Full caches evict entries that were not used recently") {
+    cache.set("a", 1);
+    cache.set("b", 2);
+    cache.set("c", 3);
+    cache.set("d", 4);
+    cache.get("a");
+    cache.get("c");
+
+    cache.set("e", 5);
+    REQUIRE(cache.size() == 4);
+    REQUIRE(cache.get("b").value_or(-1) == -1);
+    REQUIRE(cache.get("a").value_or(-1) == 1);
+    REQUIRE(cache.get("c").value_or(-1) == 3);
+    REQUIRE(cache.get("d").value_or(-1) == 4);
+    REQUIRE(cache.get("e").value_or(-1) == 5);
+    REQUIRE(cache.stats().evictions == 1);
+  }
+
+  SECTION("New entries are not marked as used until they are read") {
+    cache.set("a", 1);
+    cache.set("b", 2);
+    cache.set("c", 3);
+    cache.set("d", 4);
+    cache.get("b");
+    cache.get("c");
+    cache.get("d");
+
+    // "a" was never read, so it is evicted without clearing any other bit.
+    cache.set("e", 5);
+    REQUIRE(cache.get("a").value_or(-1) == -1);
+    REQUIRE(cache.stats().evictions == 1);
+
+    // The sweep clears "b", "c" and "d", then finds "e" unmarked because inserting it did not set its bit.
+    cache.set("f", 6);
+    REQUIRE(cache.get("e").value_or(-1) == -1);
+    REQUIRE(cache.get("b").value_or(-1) == 2);
+    REQUIRE(cache.get("c").value_or(-1) == 3);
+    REQUIRE(cache.get("d").value_or(-1) == 4);
+    REQUIRE(cache.get("f").value_or(-1) == 6);
+  }
+
+  SECTION("Statistics are counted") {
+    cache.set("a", 1);
+    cache.get("a");
+    cache.get("a");
+    cache.get("b");
+    for (int i = 0; i < 10; ++i) cache.set("token" + std::to_string(i), i);
+
+    REQUIRE(cache.stats().hits == 2);
+    REQUIRE(cache.stats().misses == 1);
+    REQUIRE(cache.stats().evictions == 7);
+    REQUIRE(cache.size() == 4);
+  }
+
+  SECTION("Removed slots are reused before evicting") {
+    cache.set("a", 1);
+    cache.set("b", 2);
+    cache.set("c", 3);
+    cache.set("d", 4);
+    cache.remove("b");
+    cache.set("e", 5);
+    REQUIRE(cache.stats().evictions == 0);
+    REQUIRE(cache.get("a").value_or(-1) == 1);
+    REQUIRE(cache.get("e").value_or(-1) == 5);
+  }
+
+  SECTION("Binned entries") {
+    ClockCache<3, int> cacheMod10(hash::mod10);
+    cacheMod10.set("a", 1);
+    cacheMod10.set("k", 2);
+    cacheMod10.set("u", 3);
+    REQUIRE(cacheMod10.remove("a") == true);
+    REQUIRE(cacheMod10.get("k").value_or(-1) == 2);
+    REQUIRE(cacheMod10.get("u").value_or(-1) == 3);
+
+    cacheMod10.set("b", 4);
+    cacheMod10.set("a", 5);
+    REQUIRE(cacheMod10.size() == 3);
+    REQUIRE(cacheMod10.get("a").value_or(-1) == 5);
+    REQUIRE(cacheMod10.get("b").value_or(-1) == -1);
+    REQUIRE(cacheMod10.get("k").value_or(-1) == 2);
+    REQUIRE(cacheMod10.get("u").value_or(-1) == 3);
+  }
+}
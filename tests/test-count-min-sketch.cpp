@@ -0,0 +1,71 @@
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "catch.hpp"
+#include "countminsketch.hpp"
+#include "promotingtable.hpp"
+
+TEST_CASE("Count-min sketch") {
+  CountMinSketch sketch(1024);
+
+  SECTION("Counts are exact without collisions") {
+    REQUIRE(sketch.estimate("free") == 0);
+    REQUIRE(sketch.add("free") == 1);
+    REQUIRE(sketch.add("free", 4) == 5);
+    REQUIRE(sketch.estimate("free") == 5);
+    sketch.clear();
+    REQUIRE(sketch.estimate("free") == 0);
+  }
+
+  SECTION("Estimates never undercount") {
+    for (uint32_t i = 0; i < 5000; ++i) sketch.add("token" + std::to_string(i % 500), 1);
+    uint64_t overcounted = 0;
+    for (uint32_t i = 0; i < 500; ++i) {
+      uint32_t estimate = sketch.estimate("token" + std::to_string(i));
+      REQUIRE(estimate >= 10);
+      overcounted += estimate - 10;
+    }
+    REQUIRE(overcounted < 500);
+  }
+
+  SECTION("Counters saturate") {
+    sketch.add("free", UINT32_MAX - 1);
+    REQUIRE(sketch.add("free", 5) == UINT32_MAX);
+  }
+
+  SECTION("Sketches have a fixed size") {
+    REQUIRE(sketch.width() == 1024);
+    REQUIRE(sketch.depth() == 4);
+    REQUIRE(sketch.memoryUsage() == 1024 * 4 * sizeof(uint32_t));
+  }
+}
+
+TEST_CASE("Promoting table") {
+  PromotingTable<0xff, int> table(3, 1024);
+
+  SECTION("Identifiers are promoted at the threshold") {
+    REQUIRE(table.add("free") == false);
+    REQUIRE(table.add("free") == false);
+    REQUIRE(table.get("free").has_value() == false);
+    REQUIRE(table.estimate("free") == 2);
+    REQUIRE(table.add("free") == true);
+    REQUIRE(table.get("free").value_or(-1) == 3);
+  }
+
+  SECTION("Promoted identifiers are counted exactly") {
+    table.add("free", 5);
+    REQUIRE(table.get("free").value_or(-1) == 5);
+    table.add("free", 2);
+    REQUIRE(table.get("free").value_or(-1) == 7);
+    REQUIRE(table.estimate("free") == 7);
+    REQUIRE(table.sketch().estimate("free") == 5);
+  }
+
+  SECTION("Rare identifiers stay out of the table") {
+    for (int i = 0; i < 1000; ++i) table.add("random" + std::to_string(i));
+    uint64_t promoted = 0;
+    table.table().removeIf([&promoted](std::string_view, const int &) { return ++promoted, false; });
+    REQUIRE(promoted < 10);
+  }
+}
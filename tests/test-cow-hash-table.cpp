@@ -0,0 +1,144 @@
+#include <atomic>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "catch.hpp"
+#include "cowhashtable.hpp"
+
+namespace {
+
+/**
+ * @brief A thread-safe memory resource that keeps track of how many bytes are currently allocated from it.
+ */
+class AtomicCountingResource : public std::pmr::memory_resource {
+ public:
+  std::atomic<size_t> allocated{0};
+
+ private:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    allocated += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+    allocated -= bytes;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+};
+
+}  // namespace
+
+TEST_CASE("Copy-on-write hash table") {
+  CowHashTable<0xfff, int> table;
+  table.set("free", 1);
+  table.set("money", 2);
+
+  SECTION("Entries can be set and deleted") {
+    REQUIRE(table.get("free").value_or(-1) == 1);
+    REQUIRE(table.get("money").value_or(-1) == 2);
+    table.set("free", 3);
+    REQUIRE(table.get("free").value_or(-1) == 3);
+    REQUIRE(table.remove("free") == true);
+    REQUIRE(table.remove("free") == false);
+    REQUIRE(table.get("free").value_or(-1) == -1);
+  }
+
+  SECTION("Snapshots are not affected by later writes") {
+    CowHashTable<0xfff, int>::Snapshot snapshot = table.snapshot();
+    table.set("free", 10);
+    table.set("winner", 20);
+    table.remove("money");
+
+    REQUIRE(snapshot.get("free").value_or(-1) == 1);
+    REQUIRE(snapshot.get("money").value_or(-1) == 2);
+    REQUIRE(snapshot.get("winner").value_or(-1) == -1);
+    REQUIRE(table.get("free").value_or(-1) == 10);
+    REQUIRE(table.get("money").value_or(-1) == -1);
+    REQUIRE(table.get("winner").value_or(-1) == 20);
+
+    int total = 0;
+    snapshot.forEach([&](std::string_view, int data) { total += data; });
+    REQUIRE(total == 3);
+  }
+
+  SECTION("Binned entries are copied with their group") {
+    CowHashTable<10, int, 4> tableMod10(hash::mod10);
+    tableMod10.set("a", 1);
+    tableMod10.set("k", 2);
+    tableMod10.set("b", 3);
+
+    CowHashTable<10, int, 4>::Snapshot snapshot = tableMod10.snapshot();
+    tableMod10.set("u", 4);
+    REQUIRE(tableMod10.remove("a") == true);
+    tableMod10.set("k", 5);
+
+    REQUIRE(snapshot.get("a").value_or(-1) == 1);
+    REQUIRE(snapshot.get("k").value_or(-1) == 2);
+    REQUIRE(snapshot.get("u").value_or(-1) == -1);
+    REQUIRE(tableMod10.get("a").value_or(-1) == -1);
+    REQUIRE(tableMod10.get("k").value_or(-1) == 5);
+    REQUIRE(tableMod10.get("u").value_or(-1) == 4);
+    REQUIRE(tableMod10.get("b").value_or(-1) == 3);
+  }
+
+  SECTION("Snapshots can be read while the table is written") {
+    for (int i = 0; i < 1000; ++i) table.set("token" + std::to_string(i), i);
+    CowHashTable<0xfff, int>::Snapshot snapshot = table.snapshot();
+
+    bool consistent = true;
+    std::thread reader([&]() {
+      for (int round = 0; round < 5; ++round)
+        for (int i = 0; i < 1000; ++i) consistent = consistent && snapshot.get("token" + std::to_string(i)) == i;
+    });
+    for (int round = 0; round < 5; ++round) {
+      for (int i = 0; i < 1000; ++i) table.set("token" + std::to_string(i), -i);
+      table.snapshot();
+    }
+    reader.join();
+
+    REQUIRE(consistent);
+    REQUIRE(table.get("token7").value_or(0) == -7);
+  }
+
+  SECTION("Snapshots can be released on reader threads") {
+    // Run under -fsanitize=thread: the table may only write in place once the reader is known to be done.
+    bool consistent = true;
+    for (int round = 0; round < 200; ++round) {
+      for (int i = 0; i < 50; ++i) table.set("token" + std::to_string(i), round);
+      std::atomic<bool> checked(true);
+      std::thread reader([&checked, snapshot = table.snapshot(), round]() {
+        for (int i = 0; i < 50; ++i)
+          if (snapshot.get("token" + std::to_string(i)) != round) checked = false;
+      });
+      // Keeps writing while the reader finishes and drops its snapshot, without waiting for it.
+      for (int write = 0; write < 20; ++write)
+        for (int i = 0; i < 50; ++i) table.set("token" + std::to_string(i), -round);
+      reader.join();
+      consistent = consistent && checked;
+    }
+    REQUIRE(consistent);
+  }
+
+  SECTION("All memory comes from the resource") {
+    AtomicCountingResource resource;
+    {
+      CowHashTable<0xfff, int> counted(hash::fnv1a_64, &resource);
+      size_t empty = resource.allocated;
+      REQUIRE(empty > 0);
+      counted.set("free", 1);
+      REQUIRE(resource.allocated >= empty + 64 * sizeof(HashEntryPtr<int>));
+
+      CowHashTable<0xfff, int>::Snapshot snapshot = counted.snapshot();
+      size_t shared = resource.allocated;
+      counted.set("free", 2);
+      REQUIRE(resource.allocated > shared);
+      REQUIRE(snapshot.get("free").value_or(-1) == 1);
+    }
+    REQUIRE(resource.allocated == 0);
+  }
+}
@@ -0,0 +1,60 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "cuckoofilter.hpp"
+
+TEST_CASE("Cuckoo filter") {
+  CuckooFilter filter(10000);
+
+  SECTION("Identifiers can be inserted, queried and removed") {
+    REQUIRE(filter.contains("message") == false);
+    REQUIRE(filter.insert("message") == true);
+    REQUIRE(filter.contains("message") == true);
+    REQUIRE(filter.size() == 1);
+    REQUIRE(filter.remove("message") == true);
+    REQUIRE(filter.contains("message") == false);
+    REQUIRE(filter.remove("message") == false);
+    REQUIRE(filter.size() == 0);
+  }
+
+  SECTION("Identifiers inserted twice must be removed twice") {
+    filter.insert("message");
+    filter.insert("message");
+    REQUIRE(filter.remove("message") == true);
+    REQUIRE(filter.contains("message") == true);
+    REQUIRE(filter.remove("message") == true);
+    REQUIRE(filter.contains("message") == false);
+  }
+
+  SECTION("A full filter has no false negatives and few false positives") {
+    std::vector<std::string> messages;
+    for (int i = 0; i < 10000; ++i) messages.push_back("message" + std::to_string(i));
+    REQUIRE(filter.insertAll(messages) == 10000);
+    for (bool found : filter.containsAll(messages)) REQUIRE(found);
+
+    uint64_t falsePositives = 0;
+    for (int i = 0; i < 100000; ++i) falsePositives += filter.contains("absent" + std::to_string(i));
+    REQUIRE(falsePositives < 200);
+    REQUIRE(filter.memoryUsage() * 8.0 / filter.size() < 14);
+
+    std::vector<std::string> half(messages.begin(), messages.begin() + 5000);
+    REQUIRE(filter.removeAll(half) == 5000);
+    REQUIRE(filter.size() == 5000);
+    for (int i = 5000; i < 10000; ++i) REQUIRE(filter.contains(messages[i]));
+  }
+
+  SECTION("Inserts fail once the filter is full") {
+    CuckooFilter small(100, 8);
+    uint64_t inserted = 0;
+    for (int i = 0; i < 1000; ++i) inserted += small.insert("message" + std::to_string(i));
+    REQUIRE(inserted >= 100);
+    REQUIRE(inserted < 1000);
+    for (uint64_t i = 0; i < inserted; ++i) REQUIRE(small.contains("message" + std::to_string(i)));
+
+    for (int i = 0; i < 10; ++i) REQUIRE(small.remove("message" + std::to_string(i)) == true);
+    REQUIRE(small.insert("new") == true);
+    REQUIRE(small.contains("new") == true);
+  }
+}
@@ -0,0 +1,88 @@
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "cuckoohashtable.hpp"
+
+TEST_CASE("Cuckoo hash table") {
+  CuckooHashTable<std::string> table;
+
+  SECTION("Empty entries") {
+    REQUIRE(table.get("test0").value_or("EMPTY") == "EMPTY");
+    REQUIRE(table.get("").value_or("EMPTY") == "EMPTY");
+    REQUIRE(table.size() == 0);
+  }
+
+  SECTION("Entries can be set and overwritten") {
+    table.set("test0", "hello, world");
+    table.set("test1", "goodbye, world");
+    REQUIRE(table.get("test0").value_or("EMPTY") == "hello, world");
+    REQUIRE(table.get("test1").value_or("EMPTY") == "goodbye, world");
+
+    table.set("test0", "hello, earth");
+    REQUIRE(table.get("test0").value_or("EMPTY") == "hello, earth");
+    REQUIRE(table.get("test1").value_or("EMPTY") == "goodbye, world");
+    REQUIRE(table.size() == 2);
+  }
+
+  SECTION("Entries can be deleted") {
+    table.set("test0", "hello, earth");
+    table.set("test1", "goodbye, earth");
+
+    REQUIRE(table.remove("test1") == true);
+    REQUIRE(table.get("test0").value_or("EMPTY") == "hello, earth");
+    REQUIRE(table.get("test1").value_or("EMPTY") == "EMPTY");
+
+    REQUIRE(table.remove("test0") == true);
+    REQUIRE(table.get("test0").value_or("EMPTY") == "EMPTY");
+    REQUIRE(table.remove("test0") == false);
+    REQUIRE(table.size() == 0);
+  }
+
+  SECTION("The table grows as entries are added") {
+    for (int i = 0; i < 10000; ++i) table.set("token" + std::to_string(i), std::to_string(i));
+    REQUIRE(table.size() == 10000);
+    REQUIRE(table.bucketCount() * CuckooHashTable<std::string>::SLOTS < 10000 * 2);
+    for (int i = 0; i < 10000; ++i) REQUIRE(table.get("token" + std::to_string(i)).value_or("EMPTY") == std::to_string(i));
+
+    for (int i = 0; i < 10000; i += 2) REQUIRE(table.remove("token" + std::to_string(i)) == true);
+    REQUIRE(table.size() == 5000);
+    for (int i = 0; i < 10000; ++i)
+      REQUIRE(table.get("token" + std::to_string(i)).value_or("EMPTY") == (i % 2 ? std::to_string(i) : "EMPTY"));
+  }
+
+  SECTION("Long identifiers") {
+    std::string identifier = "an identifier too long to be stored in its bucket";
+    table.set(identifier, "long");
+    table.set(identifier.substr(0, CuckooHashTable<std::string>::INLINE_KEY), "short");
+    REQUIRE(table.get(identifier).value_or("EMPTY") == "long");
+    REQUIRE(table.get(identifier.substr(0, CuckooHashTable<std::string>::INLINE_KEY)).value_or("EMPTY") == "short");
+    REQUIRE(table.remove(identifier) == true);
+    REQUIRE(table.get(identifier).value_or("EMPTY") == "EMPTY");
+  }
+
+  SECTION("Identifiers that share a hash") {
+    // The identifiers are runs of 'a', so they share only ten hashes between them and most of them are refused.
+    CuckooHashTable<int> tableMod10(hash::mod10);
+    std::vector<bool> stored(100);
+    for (int i = 0; i < 100; ++i) stored[i] = tableMod10.set(std::string(i + 1, 'a'), i);
+    REQUIRE(tableMod10.size() > 0);
+    REQUIRE(tableMod10.size() <= 10 * 2 * CuckooHashTable<int>::SLOTS + CuckooHashTable<int>::STASH_SIZE);
+    for (int i = 0; i < 100; ++i) REQUIRE(tableMod10.get(std::string(i + 1, 'a')).value_or(-1) == (stored[i] ? i : -1));
+
+    int refused = 0;
+    while (stored[refused]) ++refused;
+    REQUIRE(tableMod10.add(std::string(refused + 1, 'a'), refused) == false);
+
+    for (int i = 0; i < 100; ++i) {
+      if (!stored[i]) continue;
+      REQUIRE(tableMod10.set(std::string(i + 1, 'a'), -i) == true);
+      REQUIRE(tableMod10.remove(std::string(i + 1, 'a')) == true);
+      REQUIRE(tableMod10.get(std::string(i + 1, 'a')).value_or(-1) == -1);
+    }
+    REQUIRE(tableMod10.size() == 0);
+    REQUIRE(tableMod10.add(std::string(refused + 1, 'a'), refused) == true);
+    REQUIRE(tableMod10.get(std::string(refused + 1, 'a')).value_or(-1) == refused);
+  }
+}
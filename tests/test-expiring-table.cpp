@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <string>
+
+#include "catch.hpp"
+#include "expiringtable.hpp"
+#include "timerwheel.hpp"
+
+TEST_CASE("Timer wheel") {
+  TimerWheel<int> wheel(10);
+
+  SECTION("Timers become due on their tick") {
+    wheel.schedule(12, 1);
+    wheel.schedule(11, 2);
+    wheel.schedule(10, 3);
+    REQUIRE(wheel.popDue().value_or(-1) == 3);
+    REQUIRE(wheel.popDue().has_value() == false);
+
+    REQUIRE(wheel.advance(11, 100) == true);
+    REQUIRE(wheel.popDue().value_or(-1) == 2);
+    REQUIRE(wheel.popDue().has_value() == false);
+    wheel.advance(12, 100);
+    REQUIRE(wheel.popDue().value_or(-1) == 1);
+    REQUIRE(wheel.size() == 0);
+  }
+
+  SECTION("Timers far in the future cascade down the levels") {
+    wheel.schedule(10 + 5000, 1);
+    wheel.schedule(10 + 300000, 2);
+    wheel.schedule(10 + 100000000, 3);
+    REQUIRE(wheel.size() == 3);
+
+    wheel.advance(10 + 4999, UINT64_MAX);
+    REQUIRE(wheel.popDue().has_value() == false);
+    wheel.advance(10 + 5000, UINT64_MAX);
+    REQUIRE(wheel.popDue().value_or(-1) == 1);
+
+    wheel.advance(10 + 299999, UINT64_MAX);
+    REQUIRE(wheel.popDue().has_value() == false);
+    wheel.advance(10 + 300000, UINT64_MAX);
+    REQUIRE(wheel.popDue().value_or(-1) == 2);
+
+    wheel.advance(10 + 99999999, UINT64_MAX);
+    REQUIRE(wheel.popDue().has_value() == false);
+    wheel.advance(10 + 100000000, UINT64_MAX);
+    REQUIRE(wheel.popDue().value_or(-1) == 3);
+  }
+
+  SECTION("Advancing is bounded") {
+    wheel.schedule(1000, 1);
+    REQUIRE(wheel.advance(2000, 100) == false);
+    REQUIRE(wheel.current() == 110);
+    REQUIRE(wheel.advance(2000, UINT64_MAX) == true);
+    REQUIRE(wheel.popDue().value_or(-1) == 1);
+  }
+}
+
+TEST_CASE("Expiring table") {
+  using Clock = ExpiringTable<0xff, int>::Clock;
+  Clock::time_point now = Clock::now();
+  auto clock = [&now]() { return now; };
+  ExpiringTable<0xff, int> table(hash::fnv1a_64, std::chrono::seconds(1), clock);
+
+  SECTION("Entries expire after their time to live") {
+    table.set("sender", 1, std::chrono::minutes(5));
+    table.set("triplet", 2, std::chrono::seconds(30));
+    REQUIRE(table.get("sender").value_or(-1) == 1);
+    REQUIRE(table.get("triplet").value_or(-1) == 2);
+
+    now += std::chrono::seconds(30);
+    REQUIRE(table.get("triplet").value_or(-1) == -1);
+    REQUIRE(table.get("sender").value_or(-1) == 1);
+
+    now += std::chrono::minutes(5);
+    REQUIRE(table.get("sender").value_or(-1) == -1);
+  }
+
+  SECTION("Setting an entry again renews it") {
+    table.set("sender", 1, std::chrono::seconds(10));
+    now += std::chrono::seconds(8);
+    table.set("sender", 2, std::chrono::seconds(10));
+    now += std::chrono::seconds(8);
+    REQUIRE(table.get("sender").value_or(-1) == 2);
+    REQUIRE(table.expire() == 0);
+    now += std::chrono::seconds(2);
+    REQUIRE(table.get("sender").value_or(-1) == -1);
+  }
+
+  SECTION("Refreshing an entry keeps a single timer") {
+    uint64_t mostPending = 0;
+    for (int i = 0; i < 1000; ++i) {
+      table.set("sender", i, std::chrono::seconds(10));
+      mostPending = std::max(mostPending, table.pendingExpiries());
+      now += std::chrono::milliseconds(100);
+    }
+    REQUIRE(mostPending == 1);
+    REQUIRE(table.get("sender").value_or(-1) == 999);
+
+    now += std::chrono::seconds(10);
+    REQUIRE(table.expire() == 1);
+    REQUIRE(table.pendingExpiries() == 0);
+  }
+
+  SECTION("Shortening an entry's time to live schedules an earlier timer") {
+    table.set("sender", 1, std::chrono::hours(1));
+    table.set("sender", 2, std::chrono::seconds(5));
+    REQUIRE(table.pendingExpiries() == 2);
+    now += std::chrono::seconds(5);
+    REQUIRE(table.expire() == 1);
+    REQUIRE(table.pendingExpiries() == 1);
+  }
+
+  SECTION("Stale timers are taken a bounded number at a time") {
+    for (int i = 0; i < 100; ++i) {
+      table.set("token" + std::to_string(i), i, std::chrono::seconds(1));
+      table.remove("token" + std::to_string(i));
+    }
+    REQUIRE(table.pendingExpiries() == 100);
+
+    now += std::chrono::seconds(2);
+    table.get("anything");
+    REQUIRE(table.pendingExpiries() == 84);
+    REQUIRE(table.expire() == 0);
+    REQUIRE(table.pendingExpiries() == 0);
+  }
+
+  SECTION("Expired entries are reclaimed incrementally") {
+    for (int i = 0; i < 20; ++i) table.set("token" + std::to_string(i), i, std::chrono::seconds(1));
+    REQUIRE(table.pendingExpiries() == 20);
+
+    now += std::chrono::seconds(2);
+    table.get("anything");
+    REQUIRE(table.pendingExpiries() == 16);
+    table.set("fresh", 1, std::chrono::hours(1));
+    REQUIRE(table.pendingExpiries() == 13);
+    REQUIRE(table.expire() == 12);
+    REQUIRE(table.pendingExpiries() == 1);
+    REQUIRE(table.get("fresh").value_or(-1) == 1);
+  }
+
+  SECTION("Entries can be removed") {
+    table.set("sender", 1, std::chrono::seconds(10));
+    REQUIRE(table.remove("sender") == true);
+    REQUIRE(table.get("sender").value_or(-1) == -1);
+    table.set("sender", 1, std::chrono::seconds(10));
+    now += std::chrono::seconds(10);
+    REQUIRE(table.remove("sender") == false);
+    REQUIRE(table.remove("sender") == false);
+  }
+}
@@ -1,5 +1,12 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory_resource>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "catch.hpp"
 #include "hashtable.hpp"
@@ -52,6 +59,23 @@ TEST_CASE("Hash table") {
     REQUIRE(table.remove("test1") == false);
   }
 
+  SECTION("Entries can be removed by predicate") {
+    table.set("spam0", "remove me");
+    table.set("ham0", "keep me");
+    table.set("spam1", "remove me");
+    table.set("ham1", "keep me too");
+
+    REQUIRE(table.removeIf([](std::string_view identifier, const std::string &) { return identifier.rfind("spam", 0) == 0; }) == 2);
+    REQUIRE(table.get("spam0").value_or("EMPTY") == "EMPTY");
+    REQUIRE(table.get("spam1").value_or("EMPTY") == "EMPTY");
+    REQUIRE(table.get("ham0").value_or("EMPTY") == "keep me");
+    REQUIRE(table.get("ham1").value_or("EMPTY") == "keep me too");
+
+    REQUIRE(table.removeIf([](std::string_view, const std::string &data) { return data == "keep me"; }, true) == 1);
+    REQUIRE(table.get("ham0").value_or("EMPTY") == "EMPTY");
+    REQUIRE(table.get("ham1").value_or("EMPTY") == "keep me too");
+  }
+
   SECTION("Binning") {
     HashTable<10, std::string> tableMod10(hash::mod10);
 
@@ -103,6 +127,25 @@ TEST_CASE("Hash table") {
       REQUIRE(tableMod10.get("u").value_or("EMPTY") == "this is u but better");
     }
 
+    SECTION("Remove and compact binned entries") {
+      tableMod10.set("a", "this is a");
+      tableMod10.set("k", "this is k");
+      tableMod10.set("u", "this is u");
+      tableMod10.set("b", "this is b");
+
+      REQUIRE(tableMod10.removeIf([](std::string_view identifier, const std::string &) { return identifier == "a" || identifier == "u"; }, true) == 2);
+      REQUIRE(tableMod10.get("a").value_or("EMPTY") == "EMPTY");
+      REQUIRE(tableMod10.get("b").value_or("EMPTY") == "this is b");
+      REQUIRE(tableMod10.get("k").value_or("EMPTY") == "this is k");
+      REQUIRE(tableMod10.get("u").value_or("EMPTY") == "EMPTY");
+
+      tableMod10.set("u", "this is u again");
+      REQUIRE(tableMod10.get("k").value_or("EMPTY") == "this is k");
+      REQUIRE(tableMod10.get("u").value_or("EMPTY") == "this is u again");
+      REQUIRE(tableMod10.remove("k") == true);
+      REQUIRE(tableMod10.get("u").value_or("EMPTY") == "this is u again");
+    }
+
     SECTION("Delete binned entries") {
       tableMod10.set("a", "this is a");
       tableMod10.set("b", "this is b");
@@ -209,4 +252,326 @@ TEST_CASE("Hash table") {
       REQUIRE(coolerTable.get("tb").value_or("EMPTY") == "EMPTY");
     }
   }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Merging hash tables") {
+  auto sum = [](int mine, int theirs) { return mine + theirs; };
+  HashTable<0xfff, int> table;
+  HashTable<0xfff, int> other;
+
+  table.set("free", 1);
+  table.set("money", 2);
+  other.set("money", 3);
+  other.set("viagra", 4);
+
+  SECTION("Merge a single table") {
+    table.mergeFrom(other, sum);
+    REQUIRE(table.get("free").value_or(-1) == 1);
+    REQUIRE(table.get("money").value_or(-1) == 5);
+    REQUIRE(table.get("viagra").value_or(-1) == 4);
+    REQUIRE(other.get("free").value_or(-1) == -1);
+    REQUIRE(other.get("money").value_or(-1) == 3);
+  }
+
+  SECTION("Merge several tables in parallel") {
+    HashTable<0xfff, int> third;
+    third.set("free", 10);
+    third.set("winner", 20);
+
+    HashTable<0xfff, int> total;
+    total.mergeFrom({&table, &other, &third}, sum, 4);
+    REQUIRE(total.get("free").value_or(-1) == 11);
+    REQUIRE(total.get("money").value_or(-1) == 5);
+    REQUIRE(total.get("viagra").value_or(-1) == 4);
+    REQUIRE(total.get("winner").value_or(-1) == 20);
+  }
+
+  SECTION("Merge binned entries") {
+    HashTable<10, int> binned(hash::mod10);
+    HashTable<10, int> otherBinned(hash::mod10);
+    binned.set("a", 1);
+    binned.set("k", 2);
+    otherBinned.set("k", 3);
+    otherBinned.set("u", 4);
+
+    binned.mergeFrom({&otherBinned, &otherBinned}, sum, 3);
+    REQUIRE(binned.get("a").value_or(-1) == 1);
+    REQUIRE(binned.get("k").value_or(-1) == 8);
+    REQUIRE(binned.get("u").value_or(-1) == 8);
+  }
+
+  SECTION("Tables with different hash functions are rehashed") {
+    HashTable<0xfff, int> wyhashTable(hash::wyhash64);
+    wyhashTable.set("money", 10);
+    wyhashTable.set("winner", 20);
+    table.mergeFrom(wyhashTable, sum);
+    REQUIRE(table.get("money").value_or(-1) == 12);
+    REQUIRE(table.get("winner").value_or(-1) == 20);
+
+    HashTable<0xfff, int> folded(hash::fnv1a_64_folded);
+    folded.set("MONEY", 1);
+    folded.mergeFrom({&table, &other}, sum, 4);
+    REQUIRE(folded.get("money").value_or(-1) == 16);
+    REQUIRE(folded.get("FREE").value_or(-1) == 1);
+    REQUIRE(folded.get("Viagra").value_or(-1) == 4);
+
+    HashTable<0xfff, int> lambda([](std::string_view identifier) { return hash::fnv1a_64(identifier) + 1; });
+    lambda.mergeFrom(other, sum);
+    REQUIRE(lambda.get("money").value_or(-1) == 3);
+    REQUIRE(lambda.get("viagra").value_or(-1) == 4);
+  }
+}
+
+
+/**
+ * @brief A memory resource that keeps track of how many bytes are currently allocated from it.
+ */
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  size_t allocated = 0;
+
+ private:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    allocated += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+    allocated -= bytes;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+};
+
+TEST_CASE("Hash table handles") {
+  struct Counts {
+    int spam = 0;
+    int ham = 0;
+  };
+  HashTable<10, Counts> table(hash::mod10);
+
+  SECTION("Handles update entries in place") {
+    HashTable<10, Counts>::Handle handle = table.findOrInsertHandle("a");
+    REQUIRE(handle.getIdentifier() == "a");
+    handle->spam += 2;
+    handle->ham += 1;
+    (*handle).spam += 1;
+    REQUIRE(table.get("a").value().spam == 3);
+    REQUIRE(table.get("a").value().ham == 1);
+    REQUIRE(table.findOrInsertHandle("a")->spam == 3);
+    REQUIRE(table.findOrInsertHandle("b", Counts{5, 6})->ham == 6);
+  }
+
+  SECTION("Handles can be looked up without inserting") {
+    REQUIRE(table.findHandle("a").has_value() == false);
+    table.set("a", Counts{1, 2});
+    REQUIRE(table.findHandle("a").value()->ham == 2);
+  }
+
+  SECTION("Handles survive insertions but not removals") {
+    HashTable<10, Counts>::Handle handle = table.findOrInsertHandle("a");
+    table.set("k", Counts{});
+    table.set("u", Counts{});
+    REQUIRE(table.isValid(handle));
+    handle->spam = 4;
+    REQUIRE(table.get("a").value().spam == 4);
+
+    REQUIRE(table.remove("absent") == false);
+    REQUIRE(table.isValid(handle));
+    REQUIRE(table.remove("k") == true);
+    REQUIRE(table.isValid(handle) == false);
+
+    handle = table.findOrInsertHandle("a");
+    table.compact();
+    REQUIRE(table.isValid(handle) == false);
+  }
+}
+
+TEST_CASE("Hash table memory resources") {
+  CountingResource resource;
+
+  SECTION("All memory comes from the resource") {
+    {
+      HashTable<10, std::string> table(hash::mod10, &resource);
+      size_t empty = resource.allocated;
+      REQUIRE(empty > 0);
+
+      table.set("a", "this is a");
+      table.set("k", "this is an identifier too long for the small string optimization");
+      REQUIRE(resource.allocated > empty);
+
+      table.remove("k");
+      table.remove("a");
+      REQUIRE(resource.allocated == empty);
+    }
+    REQUIRE(resource.allocated == 0);
+  }
+
+  SECTION("Compaction moves the table to a new resource") {
+    HashTable<10, int> table(hash::mod10);
+    table.set("a", 1);
+    table.set("k", 2);
+    table.set("an identifier too long for the small string optimization", 3);
+
+    {
+      std::pmr::monotonic_buffer_resource arena(&resource);
+      table.compact(&arena);
+      REQUIRE(table.getResource() == &arena);
+      REQUIRE(resource.allocated > 0);
+      REQUIRE(table.get("a").value_or(-1) == 1);
+      REQUIRE(table.get("k").value_or(-1) == 2);
+      REQUIRE(table.get("an identifier too long for the small string optimization").value_or(-1) == 3);
+
+      table.set("u", 4);
+      REQUIRE(table.get("u").value_or(-1) == 4);
+      table.compact(std::pmr::new_delete_resource());
+    }
+    REQUIRE(resource.allocated == 0);
+    REQUIRE(table.get("u").value_or(-1) == 4);
+    REQUIRE(table.get("an identifier too long for the small string optimization").value_or(-1) == 3);
+  }
+
+  SECTION("Parallel merges allocate from an unsynchronized resource safely") {
+    // Run under -fsanitize=thread: neither resource may be used from two threads at once.
+    std::vector<HashTable<0xfff, int>> parts(4);
+    std::vector<const HashTable<0xfff, int> *> others;
+    for (size_t part = 0; part < parts.size(); ++part) {
+      for (int i = 0; i < 2000; ++i) parts[part].set("token" + std::to_string(i + 1000 * part), 1);
+      others.push_back(&parts[part]);
+    }
+    {
+      std::pmr::unsynchronized_pool_resource pool(&resource);
+      HashTable<0xfff, int> total(hash::fnv1a_64, &pool);
+      total.mergeFrom(others, [](int mine, int theirs) { return mine + theirs; }, 4);
+      REQUIRE(total.get("token0").value_or(-1) == 1);
+      REQUIRE(total.get("token1500").value_or(-1) == 2);
+      REQUIRE(total.get("token4999").value_or(-1) == 1);
+      REQUIRE(total.get("token5000").value_or(-1) == -1);
+
+      HashTable<0xfff, int> counted(hash::fnv1a_64, &resource);
+      counted.mergeFrom(others, [](int mine, int theirs) { return mine + theirs; }, 4);
+      REQUIRE(counted.get("token2500").value_or(-1) == 2);
+    }
+    REQUIRE(resource.allocated == 0);
+  }
+}
+
+TEST_CASE("Case-insensitive hash tables") {
+  HashTable<0xfff, int> table(hash::fnv1a_64_folded);
+  REQUIRE(table.ignoresCase() == true);
+  REQUIRE(HashTable<0xfff, int>().ignoresCase() == false);
+
+  table.set("FREE", 1);
+  REQUIRE(table.get("free").value_or(-1) == 1);
+  table.set("Free", 2);
+  REQUIRE(table.get("fReE").value_or(-1) == 2);
+
+  table.set("\u00c9T\u00c9", 3);
+  REQUIRE(table.get("\u00e9t\u00e9").value_or(-1) == 3);
+  REQUIRE(table.get("ete").value_or(-1) == -1);
+
+  REQUIRE(table.remove("free") == true);
+  REQUIRE(table.get("FREE").value_or(-1) == -1);
+  REQUIRE(table.remove("FREE") == false);
+}
+
+TEST_CASE("Saving and loading hash tables") {
+  std::string path = "test-hash-table.bin";
+  HashTable<0xfff, std::string> table;
+  table.set("free", "spam");
+  table.set("meeting", "ham");
+
+  SECTION("Tables can be saved and loaded") {
+    REQUIRE(table.save(path) == true);
+    HashTable<0xfff, std::string> loaded;
+    loaded.set("stale", "entry");
+    REQUIRE(loaded.load(path) == true);
+    REQUIRE(loaded.get("free").value_or("EMPTY") == "spam");
+    REQUIRE(loaded.get("meeting").value_or("EMPTY") == "ham");
+    REQUIRE(loaded.get("stale").value_or("EMPTY") == "EMPTY");
+
+    HashTable<0xff, std::string> wrongSize;
+    REQUIRE(wrongSize.load(path) == false);
+    REQUIRE(wrongSize.load("does-not-exist.bin") == false);
+  }
+
+  SECTION("Binned tables can be saved and loaded") {
+    HashTable<10, int> tableMod10(hash::mod10);
+    tableMod10.set("a", 1);
+    tableMod10.set("k", 2);
+    tableMod10.set("u", 3);
+    REQUIRE(tableMod10.save(path) == true);
+
+    HashTable<10, int> loaded(hash::mod10);
+    REQUIRE(loaded.load(path) == true);
+    REQUIRE(loaded.get("a").value_or(-1) == 1);
+    REQUIRE(loaded.get("k").value_or(-1) == 2);
+    REQUIRE(loaded.get("u").value_or(-1) == 3);
+    REQUIRE(loaded.remove("k") == true);
+    REQUIRE(loaded.get("u").value_or(-1) == 3);
+  }
+
+  SECTION("Files are only loaded by tables with the same hash function") {
+    HashTable<0xfff, std::string> crcTable(hash::crc32c_64);
+    crcTable.set("free", "spam");
+    REQUIRE(crcTable.save(path) == true);
+
+    HashTable<0xfff, std::string> fnvTable;
+    REQUIRE(fnvTable.load(path) == false);
+    HashTable<0xfff, std::string> loaded(hash::crc32c_64);
+    REQUIRE(loaded.load(path) == true);
+    REQUIRE(loaded.get("free").value_or("EMPTY") == "spam");
+  }
+
+  SECTION("Corrupt files leave the table unchanged") {
+    REQUIRE(table.save(path) == true);
+    std::string bytes;
+    {
+      std::ifstream in(path, std::ios::binary);
+      bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    HashTable<0xfff, std::string> loaded;
+    loaded.set("kept", "entry");
+
+    // Cut off in the middle of the last entry.
+    {
+      std::ofstream out(path, std::ios::binary | std::ios::trunc);
+      out.write(bytes.data(), std::streamsize(bytes.size() - 3));
+    }
+    REQUIRE(loaded.load(path) == false);
+    REQUIRE(loaded.get("kept").value_or("EMPTY") == "entry");
+    REQUIRE(loaded.get("free").value_or("EMPTY") == "EMPTY");
+
+    // The length of the first identifier, after the header and the entry's hash, claims far more than the file holds.
+    uint64_t length = uint64_t(1) << 62;
+    std::memcpy(&bytes[8 + 8 + sizeof(hash::Hasher) + 8 + 8], &length, sizeof(length));
+    {
+      std::ofstream out(path, std::ios::binary | std::ios::trunc);
+      out.write(bytes.data(), std::streamsize(bytes.size()));
+    }
+    REQUIRE(loaded.load(path) == false);
+    REQUIRE(loaded.get("kept").value_or("EMPTY") == "entry");
+  }
+
+  SECTION("Tables can be saved in the background") {
+    PersistJob job = table.persistAsync(path);
+    table.set("free", "changed after the snapshot");
+    table.set("winner", "spam");
+    REQUIRE(job.wait() == true);
+    REQUIRE(job.done() == true);
+
+    HashTable<0xfff, std::string> loaded;
+    REQUIRE(loaded.load(path) == true);
+    REQUIRE(loaded.get("free").value_or("EMPTY") == "spam");
+    REQUIRE(loaded.get("meeting").value_or("EMPTY") == "ham");
+    REQUIRE(loaded.get("winner").value_or("EMPTY") == "EMPTY");
+  }
+
+  SECTION("Background saves report failures") {
+    PersistJob job = table.persistAsync("does-not-exist/test-hash-table.bin");
+    REQUIRE(job.wait() == false);
+  }
+
+  std::remove(path.c_str());
+}
@@ -1,5 +1,14 @@
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
 #include "catch.hpp"
 #include "hash.hpp"
+#include "hashtable.hpp"
 
 TEST_CASE("Test FNV-1A against known hashes") {
   REQUIRE(hash::fnv1a_64("hello, world") == 0x17a1a4f267be633d);
@@ -16,3 +25,415 @@ TEST_CASE("Test mod10 against known hashes") {
   REQUIRE(hash::mod10("abacus") == 3);
   REQUIRE(hash::mod10("") == 0);
 }
+
+TEST_CASE("Test hashing views and byte spans") {
+  std::string message = "Subject: hello, world";
+  std::string_view slice = std::string_view(message).substr(9);
+  REQUIRE(hash::fnv1a_64(slice) == 0x17a1a4f267be633d);
+  REQUIRE(hash::fnv1a_64(slice.data(), slice.size()) == 0x17a1a4f267be633d);
+  REQUIRE(hash::mod10(std::string_view("abacus")) == 3);
+  REQUIRE(hash::mod10("abacus", 6) == 3);
+  REQUIRE(hash::fnv1a_64(nullptr, 0) == hash::fnv1a_64(""));
+
+  // Bytes above 0x7f must hash the same however they are passed in.
+  const unsigned char bytes[] = {0xc3, 0xa9, 0x80, 0xff};
+  REQUIRE(hash::fnv1a_64(bytes, sizeof(bytes)) == hash::fnv1a_64(std::string(reinterpret_cast<const char *>(bytes), 4)));
+}
+
+TEST_CASE("Test hashing at compile time") {
+  using namespace hash::literals;
+  static_assert(hash::fnv1a_64("hello, world") == 0x17a1a4f267be633d, "constexpr FNV-1a must match known hashes");
+  static_assert("qwerty"_h == 0x3eb459c7c3501ff9, "_h must hash with FNV-1a");
+  static_assert(hash::mod10("abacus") == 3, "constexpr mod10 must match known hashes");
+  static_assert(hash::mix64(0) == 0, "constexpr mix64 must map 0 to 0");
+
+  auto header = [](std::string_view name) {
+    switch (hash::fnv1a_64(name)) {
+      case "Subject"_h:
+        return 1;
+      case "From"_h:
+        return 2;
+      default:
+        return 0;
+    }
+  };
+  REQUIRE(header(std::string("Subject")) == 1);
+  REQUIRE(header("From") == 2);
+  REQUIRE(header("To") == 0);
+
+  std::string runtime = "\xc3\xa9t\xe9";
+  REQUIRE(hash::fnv1a_64(runtime) == "\xc3\xa9t\xe9"_h);
+}
+
+TEST_CASE("Test wyhash64") {
+  SECTION("Every length is hashed consistently") {
+    std::string data;
+    for (int i = 0; i < 200; ++i) data += char('a' + i % 26);
+    std::vector<uint64_t> hashes;
+    for (size_t length = 0; length <= data.size(); ++length) {
+      std::string key = data.substr(0, length);
+      REQUIRE(hash::wyhash64(key) == hash::wyhash64(key.data(), key.size()));
+      REQUIRE(hash::wyhash64(key) != hash::wyhash64(key.data(), key.size(), 1));
+      hashes.push_back(hash::wyhash64(key));
+    }
+    std::sort(hashes.begin(), hashes.end());
+    REQUIRE(std::adjacent_find(hashes.begin(), hashes.end()) == hashes.end());
+  }
+
+  SECTION("Flipping any input bit flips about half of the output bits") {
+    for (std::string key : {std::string("a"), std::string("free"), std::string("viagra!!"), std::string(40, 'x')}) {
+      uint64_t original = hash::wyhash64(key);
+      double flipped = 0;
+      for (size_t bit = 0; bit < key.size() * 8; ++bit) {
+        std::string changed = key;
+        changed[bit / 8] ^= char(1 << (bit % 8));
+        uint64_t difference = original ^ hash::wyhash64(changed);
+        for (; difference != 0; difference &= difference - 1) ++flipped;
+      }
+      flipped /= key.size() * 8;
+      REQUIRE(flipped > 24);
+      REQUIRE(flipped < 40);
+    }
+  }
+
+  SECTION("Hash tables accept it as their hash function") {
+    HashTable<0xff, int> table(hash::wyhash64);
+    table.set("free", 1);
+    table.set("money", 2);
+    REQUIRE(table.get("free").value_or(-1) == 1);
+    REQUIRE(table.get("money").value_or(-1) == 2);
+  }
+}
+
+TEST_CASE("Test wyhash128") {
+  SECTION("Hashes are the same on every platform") {
+    std::string bytes(1000, '\0');
+    for (size_t i = 0; i < bytes.size(); ++i) bytes[i] = char(i % 251);
+    REQUIRE(hash::wyhash128("") == hash::Hash128{0x93228a4de0eec5a2, 0x28e8efb92384411a});
+    REQUIRE(hash::wyhash128("hello, world") == hash::Hash128{0x08ed0bc1aa52fa14, 0x5df3388ee7314b90});
+    REQUIRE(hash::wyhash128(bytes.data(), 3) == hash::Hash128{0x78c4aa0c972a522d, 0x586c10fc1b34eabd});
+    REQUIRE(hash::wyhash128(bytes.data(), 17) == hash::Hash128{0xd29ffdd201a46f9a, 0x6812f5b04770cf63});
+    REQUIRE(hash::wyhash128(bytes.data(), 49) == hash::Hash128{0x0691f11bac523a91, 0x2f3fd3ebacfa63cd});
+    REQUIRE(hash::wyhash128(bytes.data(), 1000) == hash::Hash128{0x5d56bcf8ee2c4e0f, 0x56c0cdbe26c812b1});
+  }
+
+  SECTION("The low half is wyhash64") {
+    std::string data;
+    for (int i = 0; i < 300; ++i) data += char('a' + i % 26);
+    for (size_t length = 0; length <= data.size(); ++length) {
+      for (uint64_t seed : {uint64_t(0), uint64_t(9)}) {
+        hash::Hash128 fingerprint = hash::wyhash128(data.data(), length, seed);
+        REQUIRE(fingerprint.low == hash::wyhash64(data.data(), length, seed));
+        REQUIRE(fingerprint.high != fingerprint.low);
+      }
+    }
+  }
+
+  SECTION("Keys a few bits apart do not collide in either half") {
+    std::string key(64, 'x');
+    std::vector<uint64_t> lows, highs;
+    for (size_t i = 0; i < key.size() * 8; ++i) {
+      for (size_t j = i; j < key.size() * 8; j += 7) {
+        std::string changed = key;
+        changed[i / 8] ^= char(1 << (i % 8));
+        if (j != i) changed[j / 8] ^= char(1 << (j % 8));
+        hash::Hash128 fingerprint = hash::wyhash128(changed);
+        lows.push_back(fingerprint.low);
+        highs.push_back(fingerprint.high);
+      }
+    }
+    for (std::vector<uint64_t> *halves : {&lows, &highs}) {
+      std::sort(halves->begin(), halves->end());
+      REQUIRE(std::adjacent_find(halves->begin(), halves->end()) == halves->end());
+    }
+  }
+
+  SECTION("Batches match one key at a time") {
+    std::mt19937_64 rng(17);
+    std::vector<std::string> storage;
+    for (int i = 0; i < 301; ++i) storage.push_back(std::string(rng() % 120, char('a' + rng() % 26)));
+    std::vector<std::string_view> keys(storage.begin(), storage.end());
+    std::vector<hash::Hash128> hashes(keys.size());
+    hash::batch128(keys.data(), keys.size(), hashes.data());
+    for (size_t i = 0; i < keys.size(); ++i) REQUIRE(hashes[i] == hash::wyhash128(keys[i]));
+    hash::batch128(keys.data(), 0, nullptr);
+  }
+
+  SECTION("Fingerprints can be kept in unordered sets") {
+    std::unordered_set<hash::Hash128> seen;
+    REQUIRE(seen.insert(hash::wyhash128("Message-ID: <1@example.com>")).second == true);
+    REQUIRE(seen.insert(hash::wyhash128("Message-ID: <2@example.com>")).second == true);
+    REQUIRE(seen.insert(hash::wyhash128("Message-ID: <1@example.com>")).second == false);
+  }
+}
+
+TEST_CASE("Test crc32c_64") {
+  SECTION("Hashes are the same on every CPU") {
+    // Recorded from the table-driven fallback, so these also check the hardware path of the CPU running the test.
+    std::string bytes(1000, '\0');
+    for (size_t i = 0; i < bytes.size(); ++i) bytes[i] = char(i % 251);
+    REQUIRE(hash::crc32c_64("") == 0x6b0c5f733da0d6c0);
+    REQUIRE(hash::crc32c_64("hello, world") == 0x75b3221ad8032613);
+    REQUIRE(hash::crc32c_64(bytes.data(), 3) == 0x14b16b572cf43ed4);
+    REQUIRE(hash::crc32c_64(bytes.data(), 7) == 0xfbfd034972adebb3);
+    REQUIRE(hash::crc32c_64(bytes.data(), 24) == 0x82b08ad606a56486);
+    REQUIRE(hash::crc32c_64(bytes.data(), 100) == 0x7dfb7eba421b7315);
+    REQUIRE(hash::crc32c_64(bytes.data(), 1000) == 0x8f2709aadd06ce08);
+    REQUIRE(hash::crc32c_64("hello, world", 12, 1) == 0xfe5051430cf1f5ba);
+  }
+
+  SECTION("Inputs that differ only in trailing zeros hash differently") {
+    std::string key;
+    std::vector<uint64_t> hashes;
+    for (int i = 0; i < 40; ++i, key.push_back('\0')) hashes.push_back(hash::crc32c_64(key));
+    std::sort(hashes.begin(), hashes.end());
+    REQUIRE(std::adjacent_find(hashes.begin(), hashes.end()) == hashes.end());
+  }
+
+  SECTION("Changes in different lanes do not cancel out") {
+    std::string key(64, 'x');
+    std::vector<uint64_t> hashes;
+    for (size_t i = 0; i < key.size(); ++i) {
+      std::string changed = key;
+      changed[i] ^= 1;
+      hashes.push_back(hash::crc32c_64(changed));
+      for (size_t j = i + 1; j < key.size(); ++j) {
+        changed[j] ^= 1;
+        hashes.push_back(hash::crc32c_64(changed));
+        changed[j] ^= 1;
+      }
+    }
+    std::sort(hashes.begin(), hashes.end());
+    REQUIRE(std::adjacent_find(hashes.begin(), hashes.end()) == hashes.end());
+  }
+
+  SECTION("Short inputs do not collide in the full hash") {
+    // With only 32 bits of hash, around ten of these pairs would collide for each length.
+    std::mt19937_64 rng(7);
+    for (size_t length : {6, 7, 8, 12}) {
+      std::vector<std::string> keys;
+      for (int i = 0; i < (1 << 18); ++i) {
+        std::string key(length, '\0');
+        for (char &c : key) c = char(rng());
+        // The tail is shared, so that keys of 9 to 15 bytes only differ in their first word.
+        if (length > 8) key.replace(8, std::string::npos, length - 8, '_');
+        keys.push_back(key);
+      }
+      std::sort(keys.begin(), keys.end());
+      keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+      std::vector<uint64_t> hashes;
+      for (const std::string &key : keys) hashes.push_back(hash::crc32c_64(key));
+      std::sort(hashes.begin(), hashes.end());
+      REQUIRE(std::adjacent_find(hashes.begin(), hashes.end()) == hashes.end());
+    }
+  }
+
+  SECTION("Hash functions can be identified") {
+    REQUIRE(hash::identify(std::function<uint64_t(std::string_view)>(hash::crc32c_64)) == hash::Hasher::CRC32C_64);
+    REQUIRE(hash::identify(std::function<uint64_t(std::string_view)>(hash::fnv1a_64)) == hash::Hasher::FNV1A_64);
+    REQUIRE(hash::identify(std::function<uint64_t(std::string_view)>([](std::string_view) { return uint64_t(0); })) ==
+            hash::Hasher::UNKNOWN);
+  }
+}
+
+/**
+ * @brief Check that a hash function's stream gives the same hash as the function, however the data is split up.
+ */
+template <typename Hash>
+void requireStreamsMatch(Hash hash) {
+  std::mt19937_64 rng(11);
+  for (size_t length = 0; length < 300; length += 1 + length / 16) {
+    std::string data(length, '\0');
+    for (char &c : data) c = char(rng());
+    for (int split = 0; split < 8; ++split) {
+      typename Hash::Stream stream;
+      for (size_t position = 0; position < length;) {
+        size_t piece = std::min<size_t>(length - position, 1 + rng() % (split * 13 + 1));
+        stream.update(data.data() + position, piece);
+        position += piece;
+      }
+      stream.update(std::string_view());
+      REQUIRE(stream.finalize() == hash(data));
+    }
+  }
+}
+
+TEST_CASE("Test streaming hashes") {
+  SECTION("Streams match their hash functions") {
+    requireStreamsMatch(hash::fnv1a_64);
+    requireStreamsMatch(hash::mod10);
+    requireStreamsMatch(hash::wyhash64);
+    requireStreamsMatch(hash::crc32c_64);
+  }
+
+  SECTION("Seeded streams match seeded hashes") {
+    std::string data(100, 'x');
+    hash::Wyhash64::Stream wyhash(7);
+    hash::Crc32c64::Stream crc32c(7);
+    wyhash.update(data.substr(0, 60));
+    wyhash.update(data.substr(60));
+    crc32c.update(data.substr(0, 30));
+    crc32c.update(data.substr(30));
+    REQUIRE(wyhash.finalize() == hash::wyhash64(data.data(), data.size(), 7));
+    REQUIRE(crc32c.finalize() == hash::crc32c_64(data.data(), data.size(), 7));
+  }
+
+  SECTION("Streams can be finalized and then continued") {
+    hash::Fnv1a64::Stream stream;
+    stream.update("hello, ");
+    REQUIRE(stream.finalize() == hash::fnv1a_64("hello, "));
+    stream.update("world");
+    REQUIRE(stream.finalize() == hash::fnv1a_64("hello, world"));
+  }
+}
+
+TEST_CASE("Test rolling hashes") {
+  SECTION("Every n-gram hashes as it would on its own") {
+    std::string text = "buy cheap v1agra now, v1agra is cheap";
+    std::vector<uint64_t> hashes = hash::kgrams(text, 4);
+    REQUIRE(hashes.size() == text.size() - 3);
+    for (size_t i = 0; i < hashes.size(); ++i) REQUIRE(hashes[i] == hash::kgrams(text.substr(i, 4), 4)[0]);
+    REQUIRE(hashes[text.find("v1ag")] == hashes[text.rfind("v1ag")]);
+    REQUIRE(hashes[text.find("chea")] != hashes[text.find("v1ag")]);
+  }
+
+  SECTION("Different n-grams rarely collide") {
+    std::mt19937_64 rng(3);
+    std::string text(20000, '\0');
+    for (char &c : text) c = char('a' + rng() % 26);
+    for (size_t k : {size_t(3), size_t(5), size_t(8), size_t(70)}) {
+      std::vector<uint64_t> hashes = hash::kgrams(text, k);
+      std::vector<std::pair<uint64_t, std::string>> grams;
+      for (size_t i = 0; i < hashes.size(); ++i) grams.emplace_back(hashes[i], text.substr(i, k));
+      std::sort(grams.begin(), grams.end());
+      grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+      size_t collisions = 0;
+      for (size_t i = 1; i < grams.size(); ++i) collisions += grams[i].first == grams[i - 1].first;
+      REQUIRE(collisions == 0);
+    }
+  }
+
+  SECTION("Data shorter than an n-gram has none") {
+    REQUIRE(hash::kgrams("abc", 4).empty());
+    REQUIRE(hash::kgrams("abc", 0).empty());
+    REQUIRE(hash::kgrams("abc", 3).size() == 1);
+  }
+
+  SECTION("Shingles depend on the order of their words") {
+    std::vector<uint64_t> words = {hash::fnv1a_64("click"), hash::fnv1a_64("here"), hash::fnv1a_64("now"),
+                                   hash::fnv1a_64("click"), hash::fnv1a_64("here")};
+    std::vector<uint64_t> pairs = hash::shingles(words, 2);
+    REQUIRE(pairs.size() == 4);
+    REQUIRE(pairs[0] == pairs[3]);
+    REQUIRE(pairs[0] != hash::shingles({words[1], words[0]}, 2)[0]);
+    REQUIRE(pairs[1] == hash::shingles({words[1], words[2]}, 2)[0]);
+    REQUIRE(hash::shingles(words, 6).empty());
+  }
+}
+
+TEST_CASE("Test case folding") {
+  SECTION("ASCII and UTF-8 text is folded") {
+    REQUIRE(hash::foldCase("FREE Money!!") == "free money!!");
+    REQUIRE(hash::foldCase("\u212a") == "k");
+    REQUIRE(hash::foldCase("\u03a3\u03c2\u03c3") == "\u03c3\u03c3\u03c3");
+    REQUIRE(hash::foldCase("\u00c9T\u00c9") == "\u00e9t\u00e9");
+    REQUIRE(hash::foldCase("\u00df") == "\u00df");
+    REQUIRE(hash::foldCase("\U00010400") == "\U00010428");
+    REQUIRE(hash::foldCodePoint('A') == 'a');
+    REQUIRE(hash::foldCodePoint(0x212a) == 'k');
+    REQUIRE(hash::foldCodePoint(0x4e2d) == 0x4e2d);
+  }
+
+  SECTION("Invalid UTF-8 is left unchanged") {
+    REQUIRE(hash::foldCase("A\xff\xc3" "B") == "a\xff\xc3" "b");
+    REQUIRE(hash::foldCase("\xc3") == "\xc3");
+    REQUIRE(hash::foldCase("\xe2\x84") == "\xe2\x84");
+    REQUIRE(hash::foldCase("\xc0\xc1") == "\xc0\xc1");
+  }
+
+  SECTION("Comparing ignoring case agrees with folding") {
+    std::mt19937_64 rng(5);
+    const std::vector<std::string> pieces = {"a", "A", "z", "Z", "\u00e9", "\u00c9", "\u212a", "k", "K", "\xff", "\xc3", " "};
+    for (int i = 0; i < 2000; ++i) {
+      std::string a, b;
+      size_t length = rng() % 24;
+      for (size_t j = 0; j < length; ++j) a += pieces[rng() % pieces.size()];
+      length = rng() % 24;
+      for (size_t j = 0; j < length; ++j) b += pieces[rng() % pieces.size()];
+      REQUIRE(hash::equalIgnoringCase(a, b) == (hash::foldCase(a) == hash::foldCase(b)));
+      REQUIRE(hash::equalIgnoringCase(a, hash::foldCase(a)) == true);
+    }
+    REQUIRE(hash::equalIgnoringCase("Viagra Cheap Pills", "vIAGRA cHEAP pILLS") == true);
+    REQUIRE(hash::equalIgnoringCase("Viagra Cheap Pills", "Viagra Cheap Pill") == false);
+  }
+
+  SECTION("Folded hashes hash the folded text") {
+    for (const std::string &text : std::vector<std::string>{"", "FREE", "Click HERE to claim your \u212aEY", "\u00c9T\u00c9 \xff", std::string(200, 'Q')}) {
+      std::string folded = hash::foldCase(text);
+      REQUIRE(hash::fnv1a_64_folded(text) == hash::fnv1a_64(folded));
+      REQUIRE(hash::wyhash64_folded(text) == hash::wyhash64(folded));
+      REQUIRE(hash::crc32c_64_folded(text) == hash::crc32c_64(folded));
+    }
+    REQUIRE(hash::fnv1a_64_folded("Free") == hash::fnv1a_64_folded("fREE"));
+  }
+
+  SECTION("Folded streams match their hash functions") {
+    requireStreamsMatch(hash::fnv1a_64_folded);
+    requireStreamsMatch(hash::wyhash64_folded);
+    requireStreamsMatch(hash::crc32c_64_folded);
+
+    std::string text;
+    for (int i = 0; i < 20; ++i) text += "\u00c9t\u00c9 \u212a\U00010400\u03a3 ";
+    for (size_t split = 0; split <= text.size(); ++split) {
+      hash::Folded<hash::Wyhash64>::Stream stream;
+      stream.update(text.substr(0, split));
+      stream.update(text.substr(split));
+      REQUIRE(stream.finalize() == hash::wyhash64_folded(text));
+    }
+    hash::Folded<hash::Fnv1a64>::Stream bytes;
+    for (char c : text) bytes.update(&c, 1);
+    REQUIRE(bytes.finalize() == hash::fnv1a_64(hash::foldCase(text)));
+  }
+
+  SECTION("Folded hashers are identified") {
+    REQUIRE(hash::identify(std::function<uint64_t(std::string_view)>(hash::fnv1a_64_folded)) ==
+            hash::Hasher::FNV1A_64_FOLDED);
+    REQUIRE(hash::identify(std::function<uint64_t(std::string_view)>(hash::crc32c_64_folded)) ==
+            hash::Hasher::CRC32C_64_FOLDED);
+    REQUIRE(hash::ignoresCase(hash::Hasher::WYHASH_64_FOLDED) == true);
+    REQUIRE(hash::ignoresCase(hash::Hasher::WYHASH_64) == false);
+  }
+}
+
+TEST_CASE("Test mix64") {
+  REQUIRE(hash::mix64(0) == 0);
+  REQUIRE(hash::mix64(1) != hash::mix64(2));
+  REQUIRE((hash::mix64(hash::fnv1a_64("token1")) >> 32) != (hash::mix64(hash::fnv1a_64("token2")) >> 32));
+}
+
+TEST_CASE("Test batch hashing") {
+  std::mt19937_64 rng(7);
+  std::vector<std::string> storage;
+  for (int i = 0; i < 203; ++i) {
+    std::string key(rng() % 101, '\0');
+    // Bytes above 0x7f are sign-extended by fnv1a_64, so they must be included.
+    for (char &c : key) c = char(rng());
+    storage.push_back(key);
+  }
+  std::vector<std::string_view> keys(storage.begin(), storage.end());
+
+  SECTION("Every hash matches fnv1a_64") {
+    std::vector<uint64_t> hashes(keys.size());
+    hash::batch(keys.data(), keys.size(), hashes.data());
+    for (size_t i = 0; i < keys.size(); ++i) REQUIRE(hashes[i] == hash::fnv1a_64(keys[i]));
+  }
+
+  SECTION("Batches of any size match fnv1a_64") {
+    for (size_t count : {size_t(0), size_t(1), size_t(7), size_t(15), size_t(16), size_t(17), size_t(33)}) {
+      std::vector<uint64_t> hashes(count + 1, 42);
+      hash::batch(keys.data(), count, hashes.data());
+      for (size_t i = 0; i < count; ++i) REQUIRE(hashes[i] == hash::fnv1a_64(keys[i]));
+      REQUIRE(hashes[count] == 42);
+    }
+  }
+}
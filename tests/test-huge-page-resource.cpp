@@ -0,0 +1,40 @@
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+
+#include "catch.hpp"
+#include "hashtable.hpp"
+#include "hugepageresource.hpp"
+
+TEST_CASE("Huge page resource") {
+  HugePageResource resource;
+
+  SECTION("Small allocations use the fallback") {
+    void *p = resource.allocate(64, 8);
+    std::memset(p, 0xab, 64);
+    REQUIRE(resource.stats().fallback == 64);
+    REQUIRE(resource.stats().hugetlb + resource.stats().madvised == 0);
+    resource.deallocate(p, 64, 8);
+  }
+
+  SECTION("Large allocations are huge page aligned") {
+    size_t bytes = HugePageResource::HUGE_PAGE_SIZE * 2 + 100;
+    void *p = resource.allocate(bytes, 64);
+    REQUIRE(reinterpret_cast<uintptr_t>(p) % 64 == 0);
+    std::memset(p, 0xab, bytes);
+    REQUIRE(static_cast<unsigned char *>(p)[bytes - 1] == 0xab);
+#if defined(__unix__) || defined(__APPLE__)
+    REQUIRE(reinterpret_cast<uintptr_t>(p) % HugePageResource::HUGE_PAGE_SIZE == 0);
+    REQUIRE(resource.stats().hugetlb + resource.stats().madvised == HugePageResource::HUGE_PAGE_SIZE * 3);
+#endif
+    resource.deallocate(p, bytes, 64);
+  }
+
+  SECTION("A hash table can live on huge pages") {
+    std::pmr::monotonic_buffer_resource arena(HugePageResource::HUGE_PAGE_SIZE, &resource);
+    HashTable<0x3ffff, int> table(hash::fnv1a_64, &arena);
+    for (int i = 0; i < 1000; ++i) table.set("token" + std::to_string(i), i);
+    for (int i = 0; i < 1000; ++i) REQUIRE(table.get("token" + std::to_string(i)).value_or(-1) == i);
+    REQUIRE(resource.stats().fallback == 0);
+  }
+}
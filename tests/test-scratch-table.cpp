@@ -0,0 +1,77 @@
+#include <optional>
+#include <string>
+
+#include "catch.hpp"
+#include "scratchtable.hpp"
+
+TEST_CASE("Scratch table") {
+  ScratchTable<64, int> table;
+
+  SECTION("Entries can be set and overwritten") {
+    REQUIRE(table.get("test0").value_or(-1) == -1);
+    REQUIRE(table.set("test0", 1) == true);
+    REQUIRE(table.set("test1", 2) == true);
+    REQUIRE(table.get("test0").value_or(-1) == 1);
+    REQUIRE(table.get("test1").value_or(-1) == 2);
+
+    REQUIRE(table.set("test0", 3) == true);
+    REQUIRE(table.get("test0").value_or(-1) == 3);
+    REQUIRE(table.size() == 2);
+  }
+
+  SECTION("Entries can only be added once") {
+    REQUIRE(table.add("free", 1) == true);
+    REQUIRE(table.add("money", 1) == true);
+    REQUIRE(table.add("free", 2) == false);
+    REQUIRE(table.get("free").value_or(-1) == 1);
+    REQUIRE(table.size() == 2);
+  }
+
+  SECTION("Clearing empties the table") {
+    table.set("test0", 1);
+    table.set("test1", 2);
+    table.clear();
+    REQUIRE(table.size() == 0);
+    REQUIRE(table.get("test0").value_or(-1) == -1);
+    REQUIRE(table.get("test1").value_or(-1) == -1);
+
+    REQUIRE(table.add("test1", 4) == true);
+    REQUIRE(table.get("test1").value_or(-1) == 4);
+    REQUIRE(table.get("test0").value_or(-1) == -1);
+  }
+
+  SECTION("Full tables reject new entries") {
+    ScratchTable<4, int> small;
+    REQUIRE(small.set("a", 1) == true);
+    REQUIRE(small.set("b", 2) == true);
+    REQUIRE(small.set("c", 3) == true);
+    REQUIRE(small.set("d", 4) == true);
+    REQUIRE(small.set("e", 5) == false);
+    REQUIRE(small.set("a", 6) == true);
+    REQUIRE(small.get("a").value_or(-1) == 6);
+
+    REQUIRE(small.remove("c") == true);
+    REQUIRE(small.get("d").value_or(-1) == 4);
+    REQUIRE(small.set("e", 5) == true);
+  }
+
+  SECTION("Binned entries survive removal") {
+    ScratchTable<10, int> tableMod10(hash::mod10);
+    tableMod10.set("a", 1);
+    tableMod10.set("k", 2);
+    tableMod10.set("u", 3);
+    tableMod10.set("b", 4);
+
+    REQUIRE(tableMod10.remove("a") == true);
+    REQUIRE(tableMod10.get("a").value_or(-1) == -1);
+    REQUIRE(tableMod10.get("k").value_or(-1) == 2);
+    REQUIRE(tableMod10.get("u").value_or(-1) == 3);
+    REQUIRE(tableMod10.get("b").value_or(-1) == 4);
+
+    REQUIRE(tableMod10.remove("u") == true);
+    REQUIRE(tableMod10.get("k").value_or(-1) == 2);
+    REQUIRE(tableMod10.get("b").value_or(-1) == 4);
+    REQUIRE(tableMod10.remove("u") == false);
+    REQUIRE(tableMod10.size() == 2);
+  }
+}
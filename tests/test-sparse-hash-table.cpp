@@ -0,0 +1,166 @@
+#include <memory_resource>
+#include <optional>
+#include <string>
+
+#include "catch.hpp"
+#include "sparsehashtable.hpp"
+
+namespace {
+/**
+ * @brief A memory resource that keeps track of how many bytes are currently allocated from it.
+ */
+class SparseCountingResource : public std::pmr::memory_resource {
+ public:
+  size_t allocated = 0;
+
+ private:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    allocated += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+    allocated -= bytes;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+};
+}  // namespace
+
+TEST_CASE("Sparse array") {
+  SparseArray<int, 1000> array;
+
+  SECTION("Empty slots") {
+    REQUIRE(array.get(0) == nullptr);
+    REQUIRE(array.get(999) == nullptr);
+    REQUIRE(array.count() == 0);
+  }
+
+  SECTION("Slots can be set out of order") {
+    array.set(70, 7);
+    array.set(64, 6);
+    array.set(127, 12);
+    array.set(65, 65);
+    REQUIRE(*array.get(64) == 6);
+    REQUIRE(*array.get(65) == 65);
+    REQUIRE(*array.get(70) == 7);
+    REQUIRE(*array.get(127) == 12);
+    REQUIRE(array.get(66) == nullptr);
+    REQUIRE(array.count() == 4);
+
+    array.set(70, 8);
+    REQUIRE(*array.get(70) == 8);
+    REQUIRE(array.count() == 4);
+  }
+
+  SECTION("Slots can be erased") {
+    array.set(3, 3);
+    array.set(5, 5);
+    array.set(9, 9);
+
+    REQUIRE(array.erase(5) == true);
+    REQUIRE(*array.get(3) == 3);
+    REQUIRE(array.get(5) == nullptr);
+    REQUIRE(*array.get(9) == 9);
+    REQUIRE(array.erase(5) == false);
+    REQUIRE(array.count() == 2);
+  }
+
+  SECTION("Empty slots cost almost nothing") {
+    uint64_t empty = array.memoryUsage();
+    REQUIRE(empty < 1000);
+    array.set(500, 1);
+    REQUIRE(array.memoryUsage() == empty + sizeof(int));
+    array.erase(500);
+    REQUIRE(array.memoryUsage() == empty);
+  }
+
+  SECTION("All memory comes from the resource") {
+    SparseCountingResource resource;
+    {
+      SparseArray<std::string, 1000> strings(&resource);
+      REQUIRE(resource.allocated == strings.memoryUsage());
+      strings.set(3, "three");
+      strings.set(1, "one");
+      strings.set(999, "nine hundred and ninety-nine");
+      REQUIRE(resource.allocated == strings.memoryUsage());
+      REQUIRE(*strings.get(1) == "one");
+      REQUIRE(*strings.get(3) == "three");
+      strings.erase(3);
+      REQUIRE(resource.allocated == strings.memoryUsage());
+    }
+    REQUIRE(resource.allocated == 0);
+  }
+}
+
+TEST_CASE("Sparse hash table") {
+  SparseHashTable<0xfffff, std::string> table;
+
+  SECTION("Empty entries") {
+    REQUIRE(table.get("test0").value_or("EMPTY") == "EMPTY");
+    REQUIRE(table.get("").value_or("EMPTY") == "EMPTY");
+    REQUIRE(table.bucketMemoryUsage() < 0xfffff);
+  }
+
+  SECTION("Entries can be set and overwritten") {
+    table.set("test0", "hello, world");
+    table.set("test1", "goodbye, world");
+    REQUIRE(table.get("test0").value_or("EMPTY") == "hello, world");
+    REQUIRE(table.get("test1").value_or("EMPTY") == "goodbye, world");
+
+    table.set("test0", "hello, earth");
+    REQUIRE(table.get("test0").value_or("EMPTY") == "hello, earth");
+    REQUIRE(table.get("test1").value_or("EMPTY") == "goodbye, world");
+  }
+
+  SECTION("Entries can be deleted") {
+    uint64_t empty = table.bucketMemoryUsage();
+    table.set("test0", "hello, earth");
+    table.set("test1", "goodbye, earth");
+
+    REQUIRE(table.remove("test1") == true);
+    REQUIRE(table.get("test0").value_or("EMPTY") == "hello, earth");
+    REQUIRE(table.get("test1").value_or("EMPTY") == "EMPTY");
+
+    REQUIRE(table.remove("test0") == true);
+    REQUIRE(table.get("test0").value_or("EMPTY") == "EMPTY");
+    REQUIRE(table.remove("test0") == false);
+    REQUIRE(table.bucketMemoryUsage() == empty);
+  }
+
+  SECTION("All memory comes from the resource") {
+    SparseCountingResource resource;
+    {
+      SparseHashTable<0xffff, std::string> counted(hash::fnv1a_64, &resource);
+      size_t empty = resource.allocated;
+      REQUIRE(empty == counted.bucketMemoryUsage());
+      counted.set("test0", "an entry too long for the small string optimization");
+      counted.set("test1", "goodbye, world");
+      REQUIRE(resource.allocated > empty);
+      REQUIRE(counted.remove("test0") == true);
+      REQUIRE(counted.remove("test1") == true);
+      REQUIRE(resource.allocated == empty);
+    }
+    REQUIRE(resource.allocated == 0);
+  }
+
+  SECTION("Binning") {
+    SparseHashTable<10, std::string> tableMod10(hash::mod10);
+    tableMod10.set("a", "this is a");
+    tableMod10.set("k", "this is k");
+    tableMod10.set("u", "this is u");
+
+    tableMod10.set("k", "this is k but better");
+    REQUIRE(tableMod10.get("a").value_or("EMPTY") == "this is a");
+    REQUIRE(tableMod10.get("k").value_or("EMPTY") == "this is k but better");
+    REQUIRE(tableMod10.get("u").value_or("EMPTY") == "this is u");
+
+    REQUIRE(tableMod10.remove("a") == true);
+    REQUIRE(tableMod10.get("a").value_or("EMPTY") == "EMPTY");
+    REQUIRE(tableMod10.get("k").value_or("EMPTY") == "this is k but better");
+    REQUIRE(tableMod10.remove("u") == true);
+    REQUIRE(tableMod10.remove("k") == true);
+    REQUIRE(tableMod10.get("k").value_or("EMPTY") == "EMPTY");
+  }
+}